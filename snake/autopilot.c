@@ -0,0 +1,225 @@
+#include "autopilot.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CYCLE_MAGIC 0x31435943534b4e53ULL // "SNKSCYC1"
+
+// --- Cache file layout: this header, then path[cells], then index[cells] ---
+typedef struct {
+    uint64_t magic;
+    int32_t width, height;
+} CycleHeader;
+
+// --- Construction ---
+// A boustrophedon over the rows, returning up column 0, is a cycle when
+// the height is even; transposed, when the width is even. With both odd
+// the board wraps, so the odd last row is spliced in: the edge (2, h-2) ->
+// (1, h-2) of the cycle over the other rows becomes a detour down to row
+// h-1, all the way round it from x = 2 to x = 1, and back up.
+static void BuildEven(int32_t *path, int w, int h, bool transpose) {
+    int n = 0;
+#define PUT(x, y) (path[n++] = transpose ? (x) * h + (y) : (y) * w + (x))
+    for (int y = 0; y < h; y++) {
+        if (y % 2 == 0) {
+            for (int x = y == 0 ? 0 : 1; x < w; x++) PUT(x, y);
+        } else {
+            for (int x = w - 1; x >= 1; x--) PUT(x, y);
+        }
+    }
+    for (int y = h - 1; y >= 1; y--) PUT(0, y);
+#undef PUT
+}
+
+static void Build(int32_t *path, int w, int h) {
+    if (w == 1 || h == 1) {
+        for (int i = 0; i < w * h; i++) path[i] = i; // A ring through the wrap
+    } else if (h % 2 == 0) {
+        BuildEven(path, w, h, false);
+    } else if (w % 2 == 0) {
+        BuildEven(path, h, w, true);
+    } else {
+        int rows = (h - 1) * w;
+        BuildEven(path, w, h - 1, false);
+        int at = 0;
+        while (path[at] != (h - 2) * w + 2) at++;
+        memmove(path + at + 1 + w, path + at + 1, (size_t)(rows - at - 1) * sizeof(int32_t));
+        for (int k = 0; k < w; k++) {
+            path[at + 1 + k] = (h - 1) * w + (2 + k) % w; // 2, 3, ..., w-1, 0, 1
+        }
+    }
+}
+
+// --- A cache file is trusted only if it really is a cycle of the board ---
+static bool Valid(const SnakeCycle *c) {
+    int w = c->width;
+    int h = c->height;
+    for (int i = 0; i < c->cells; i++) {
+        int cell = c->path[i];
+        if (cell < 0 || cell >= c->cells || c->index[cell] != i) {
+            return false;
+        }
+        int next = c->path[(i + 1) % c->cells];
+        int dx = abs(cell % w - next % w);
+        int dy = abs(cell / w - next / w);
+        bool adjacent = (dy == 0 && (dx == 1 || dx == w - 1)) ||
+                        (dx == 0 && (dy == 1 || dy == h - 1));
+        if (!adjacent) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void *MapCache(const char *path, size_t size) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    void *map = NULL;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size == size) {
+        map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            map = NULL;
+        }
+    }
+    close(fd);
+    return map;
+}
+
+// --- Write the cache through a temporary file, so readers never see half of it ---
+static void WriteCache(const char *path, const void *data, size_t size) {
+    char temp[4096];
+    int len = snprintf(temp, sizeof(temp), "%s.%ld.tmp", path, (long)getpid());
+    int fd = len > 0 && (size_t)len < sizeof(temp) ? open(temp, O_WRONLY | O_CREAT | O_TRUNC, 0644) : -1;
+    if (fd < 0) {
+        return; // Best effort: the cycle still works from memory
+    }
+    bool ok = write(fd, data, size) == (ssize_t)size;
+    ok = close(fd) == 0 && ok;
+    if (!ok || rename(temp, path) != 0) {
+        unlink(temp);
+    }
+}
+
+static void Bind(SnakeCycle *c, void *base) {
+    c->path = (const int32_t *)((char *)base + sizeof(CycleHeader));
+    c->index = c->path + c->cells;
+}
+
+const char *SnakeCycleCacheDir(void) {
+    const char *dir = getenv("SNAKE_CACHE_DIR");
+    if (dir == NULL || dir[0] == '\0') {
+        dir = getenv("XDG_CACHE_HOME");
+    }
+    return dir != NULL && dir[0] != '\0' ? dir : "/tmp";
+}
+
+SnakeCycle *SnakeCycleOpen(int width, int height, const char *cacheDir) {
+    if (width < 1 || height < 1 || width * height < 2) {
+        return NULL;
+    }
+    SnakeCycle *c = malloc(sizeof(SnakeCycle));
+    if (c == NULL) {
+        return NULL;
+    }
+    c->width = width;
+    c->height = height;
+    c->cells = width * height;
+    size_t size = sizeof(CycleHeader) + 2 * (size_t)c->cells * sizeof(int32_t);
+
+    char file[4096];
+    if (cacheDir != NULL) {
+        int len = snprintf(file, sizeof(file), "%s/snake-cycle-%dx%d.bin", cacheDir, width, height);
+        if (len < 0 || (size_t)len >= sizeof(file)) {
+            cacheDir = NULL; // Path too long: build in memory
+        }
+    }
+    if (cacheDir != NULL) {
+        void *map = MapCache(file, size);
+        if (map != NULL) {
+            const CycleHeader *hdr = map;
+            c->mapping = map;
+            c->mappingSize = size;
+            Bind(c, map);
+            if (hdr->magic == CYCLE_MAGIC && hdr->width == width && hdr->height == height && Valid(c)) {
+                return c;
+            }
+            munmap(map, size); // Stale or damaged: rebuild it
+        }
+    }
+
+    char *block = malloc(size);
+    if (block == NULL) {
+        free(c);
+        return NULL;
+    }
+    *(CycleHeader *)block = (CycleHeader){ CYCLE_MAGIC, width, height };
+    int32_t *path = (int32_t *)(block + sizeof(CycleHeader));
+    int32_t *index = path + c->cells;
+    Build(path, width, height);
+    for (int i = 0; i < c->cells; i++) {
+        index[path[i]] = i;
+    }
+    c->mapping = block;
+    c->mappingSize = 0;
+    Bind(c, block);
+    if (cacheDir != NULL) {
+        WriteCache(file, block, size);
+    }
+    return c;
+}
+
+void SnakeCycleClose(SnakeCycle *c) {
+    if (c == NULL) {
+        return;
+    }
+    if (c->mappingSize != 0) {
+        munmap(c->mapping, c->mappingSize);
+    } else {
+        free(c->mapping);
+    }
+    free(c);
+}
+
+enum eDirection SnakeAutopilot(const SnakeGame *g, const SnakeCycle *c) {
+    int n = c->cells;
+    int head = SnakeHeadCell(g);
+    int at = c->index[head];
+#define AHEAD(cell) ((c->index[cell] - at + n) % n) // Steps along the cycle from the head
+
+    int food = SnakeFoodCell(g);
+    int toFood = food >= 0 ? AHEAD(food) : n;
+    int toTail = g->nTail > 0 ? AHEAD(SnakeTailCell(g, g->nTail - 1)) : n;
+
+    // Default: the next cell of the cycle. A shortcut must land at or
+    // before the food, and at least two cells short of the tail so that
+    // eating on the way cannot close the gap.
+    int bestAhead = 1;
+    int next = c->path[(at + 1) % n];
+    for (enum eDirection d = LEFT; d <= DOWN; d++) {
+        int cell = SnakeNeighbor(g, head, d);
+        int ahead = AHEAD(cell);
+        if (ahead > bestAhead && ahead <= toFood && ahead < toTail - 2 &&
+            !SnakeCellOccupied(g, cell)) {
+            bestAhead = ahead;
+            next = cell;
+        }
+    }
+#undef AHEAD
+
+    // On a board 2 cells across two directions reach the same cell; avoid
+    // the one SnakeSteer() would refuse as a reversal.
+    for (enum eDirection d = LEFT; d <= DOWN; d++) {
+        if (SnakeNeighbor(g, head, d) == next && d != SnakeOpposite(g->lastMove)) {
+            return d;
+        }
+    }
+    return STOP; // Not reached: next is always a neighbour
+}
@@ -0,0 +1,39 @@
+#ifndef SNAKE_AUTOPILOT_H
+#define SNAKE_AUTOPILOT_H
+
+#include <stdint.h>
+
+#include "engine.h"
+
+// --- Hamiltonian-Cycle Autopilot ---
+// Follows a cycle through every cell of the board, which can never run
+// into the body, and so always fills the board. While the way is clear it
+// cuts across the cycle towards the food: a shortcut is taken only if it
+// stays behind the food and leaves a gap before the tail in cycle order,
+// so the body keeps lying along the cycle and the guarantee holds.
+//
+// Cycles are built once per board size and cached in a file that later
+// runs map straight into memory.
+
+typedef struct SnakeCycle {
+    int width, height, cells;
+    const int32_t *path;      // path[i]: cell i steps along the cycle from cell 0
+    const int32_t *index;     // index[cell]: position of the cell on the cycle
+    void *mapping;            // Cache file mapping or heap block backing both arrays
+    size_t mappingSize;       // 0 for a heap block
+} SnakeCycle;
+
+// --- Build or load the cycle for a board size ---
+// cacheDir holds one file per size; NULL, or a directory that cannot be
+// used, builds the cycle in memory. Returns NULL if memory runs out or
+// the board has fewer than 2 cells.
+SnakeCycle *SnakeCycleOpen(int width, int height, const char *cacheDir);
+void SnakeCycleClose(SnakeCycle *cycle);
+
+// --- $SNAKE_CACHE_DIR, else $XDG_CACHE_HOME, else /tmp ---
+const char *SnakeCycleCacheDir(void);
+
+// --- Next move for a game on the cycle's board size ---
+enum eDirection SnakeAutopilot(const SnakeGame *game, const SnakeCycle *cycle);
+
+#endif
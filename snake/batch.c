@@ -0,0 +1,390 @@
+#include "batch.h"
+#include "cellset.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BATCH_X86 1
+#endif
+
+#define BATCH_ALIGN 64 // Each array starts on its own cache line
+
+// --- Round a size up to the array alignment ---
+static size_t AlignUp(size_t n) {
+    return (n + BATCH_ALIGN - 1) & ~(size_t)(BATCH_ALIGN - 1);
+}
+
+// --- Hand out the next aligned slice of the batch allocation ---
+static void *Carve(char **p, size_t bytes) {
+    void *slice = *p;
+    *p += AlignUp(bytes);
+    return slice;
+}
+
+// --- Move kernels ---
+// Each kernel handles lanes [start, end): it applies the steering rule of
+// SnakeSteer() to dir, then fills nextX/nextY with the wrapped head move and
+// grow with -1 where the new head is on the food. Direction arithmetic is
+// branch-free so it maps onto vector lanes:
+//   opposite(d) = ((d - 1) ^ 1) + 1   (LEFT<->RIGHT, UP<->DOWN)
+//   dx = (d == LEFT ? -1 : 0) + (d == RIGHT ? 1 : 0), likewise dy
+
+static void MoveKernelScalar(SnakeBatch *b, const uint8_t *actions, int start, int end) {
+    int w = b->width;
+    int h = b->height;
+    for (int i = start; i < end; i++) {
+        int a = actions[i];
+        int d = b->dir[i];
+        if (a != STOP && (((a - 1) ^ 1) + 1) != b->lastMove[i]) {
+            d = a;
+        }
+        b->dir[i] = d;
+
+        int x = b->headX[i] + (d == RIGHT) - (d == LEFT);
+        int y = b->headY[i] + (d == DOWN) - (d == UP);
+        if (x < 0) x = w - 1; else if (x == w) x = 0;
+        if (y < 0) y = h - 1; else if (y == h) y = 0;
+        b->nextX[i] = x;
+        b->nextY[i] = y;
+        b->grow[i] = -(d != STOP && x == b->foodX[i] && y == b->foodY[i]);
+    }
+}
+
+#ifdef BATCH_X86
+__attribute__((target("sse4.1")))
+static void MoveKernelSse41(SnakeBatch *b, const uint8_t *actions, int start, int end) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i left = _mm_set1_epi32(LEFT), right = _mm_set1_epi32(RIGHT);
+    const __m128i up = _mm_set1_epi32(UP), down = _mm_set1_epi32(DOWN);
+    const __m128i w = _mm_set1_epi32(b->width), wLast = _mm_set1_epi32(b->width - 1);
+    const __m128i h = _mm_set1_epi32(b->height), hLast = _mm_set1_epi32(b->height - 1);
+
+    int i = start;
+    for (; i + 4 <= end; i += 4) {
+        int32_t packed;
+        memcpy(&packed, actions + i, sizeof(packed));
+        __m128i a = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(packed));
+        __m128i d = _mm_loadu_si128((const __m128i *)(b->dir + i));
+        __m128i last = _mm_loadu_si128((const __m128i *)(b->lastMove + i));
+        __m128i opp = _mm_add_epi32(_mm_xor_si128(_mm_sub_epi32(a, one), one), one);
+        __m128i reject = _mm_or_si128(_mm_cmpeq_epi32(a, zero), _mm_cmpeq_epi32(opp, last));
+        d = _mm_blendv_epi8(a, d, reject);
+        _mm_storeu_si128((__m128i *)(b->dir + i), d);
+
+        __m128i dx = _mm_sub_epi32(_mm_cmpeq_epi32(d, left), _mm_cmpeq_epi32(d, right));
+        __m128i dy = _mm_sub_epi32(_mm_cmpeq_epi32(d, up), _mm_cmpeq_epi32(d, down));
+        __m128i x = _mm_add_epi32(_mm_loadu_si128((const __m128i *)(b->headX + i)), dx);
+        __m128i y = _mm_add_epi32(_mm_loadu_si128((const __m128i *)(b->headY + i)), dy);
+        x = _mm_blendv_epi8(x, wLast, _mm_cmpgt_epi32(zero, x));
+        x = _mm_andnot_si128(_mm_cmpeq_epi32(x, w), x);
+        y = _mm_blendv_epi8(y, hLast, _mm_cmpgt_epi32(zero, y));
+        y = _mm_andnot_si128(_mm_cmpeq_epi32(y, h), y);
+        _mm_storeu_si128((__m128i *)(b->nextX + i), x);
+        _mm_storeu_si128((__m128i *)(b->nextY + i), y);
+
+        __m128i onFood = _mm_and_si128(
+            _mm_cmpeq_epi32(x, _mm_loadu_si128((const __m128i *)(b->foodX + i))),
+            _mm_cmpeq_epi32(y, _mm_loadu_si128((const __m128i *)(b->foodY + i))));
+        _mm_storeu_si128((__m128i *)(b->grow + i),
+                         _mm_andnot_si128(_mm_cmpeq_epi32(d, zero), onFood));
+    }
+    MoveKernelScalar(b, actions, i, end);
+}
+
+__attribute__((target("avx2")))
+static void MoveKernelAvx2(SnakeBatch *b, const uint8_t *actions, int start, int end) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i left = _mm256_set1_epi32(LEFT), right = _mm256_set1_epi32(RIGHT);
+    const __m256i up = _mm256_set1_epi32(UP), down = _mm256_set1_epi32(DOWN);
+    const __m256i w = _mm256_set1_epi32(b->width), wLast = _mm256_set1_epi32(b->width - 1);
+    const __m256i h = _mm256_set1_epi32(b->height), hLast = _mm256_set1_epi32(b->height - 1);
+
+    int i = start;
+    for (; i + 8 <= end; i += 8) {
+        __m256i a = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(actions + i)));
+        __m256i d = _mm256_loadu_si256((const __m256i *)(b->dir + i));
+        __m256i last = _mm256_loadu_si256((const __m256i *)(b->lastMove + i));
+        __m256i opp = _mm256_add_epi32(_mm256_xor_si256(_mm256_sub_epi32(a, one), one), one);
+        __m256i reject = _mm256_or_si256(_mm256_cmpeq_epi32(a, zero),
+                                         _mm256_cmpeq_epi32(opp, last));
+        d = _mm256_blendv_epi8(a, d, reject);
+        _mm256_storeu_si256((__m256i *)(b->dir + i), d);
+
+        __m256i dx = _mm256_sub_epi32(_mm256_cmpeq_epi32(d, left), _mm256_cmpeq_epi32(d, right));
+        __m256i dy = _mm256_sub_epi32(_mm256_cmpeq_epi32(d, up), _mm256_cmpeq_epi32(d, down));
+        __m256i x = _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)(b->headX + i)), dx);
+        __m256i y = _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)(b->headY + i)), dy);
+        x = _mm256_blendv_epi8(x, wLast, _mm256_cmpgt_epi32(zero, x));
+        x = _mm256_andnot_si256(_mm256_cmpeq_epi32(x, w), x);
+        y = _mm256_blendv_epi8(y, hLast, _mm256_cmpgt_epi32(zero, y));
+        y = _mm256_andnot_si256(_mm256_cmpeq_epi32(y, h), y);
+        _mm256_storeu_si256((__m256i *)(b->nextX + i), x);
+        _mm256_storeu_si256((__m256i *)(b->nextY + i), y);
+
+        __m256i onFood = _mm256_and_si256(
+            _mm256_cmpeq_epi32(x, _mm256_loadu_si256((const __m256i *)(b->foodX + i))),
+            _mm256_cmpeq_epi32(y, _mm256_loadu_si256((const __m256i *)(b->foodY + i))));
+        _mm256_storeu_si256((__m256i *)(b->grow + i),
+                            _mm256_andnot_si256(_mm256_cmpeq_epi32(d, zero), onFood));
+    }
+    MoveKernelScalar(b, actions, i, end);
+}
+
+__attribute__((target("avx512f")))
+static void MoveKernelAvx512(SnakeBatch *b, const uint8_t *actions, int start, int end) {
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i one = _mm512_set1_epi32(1);
+    const __m512i allOnes = _mm512_set1_epi32(-1);
+    const __m512i left = _mm512_set1_epi32(LEFT), right = _mm512_set1_epi32(RIGHT);
+    const __m512i up = _mm512_set1_epi32(UP), down = _mm512_set1_epi32(DOWN);
+    const __m512i w = _mm512_set1_epi32(b->width), wLast = _mm512_set1_epi32(b->width - 1);
+    const __m512i h = _mm512_set1_epi32(b->height), hLast = _mm512_set1_epi32(b->height - 1);
+
+    int i = start;
+    for (; i + 16 <= end; i += 16) {
+        __m512i a = _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i *)(actions + i)));
+        __m512i d = _mm512_loadu_si512(b->dir + i);
+        __m512i last = _mm512_loadu_si512(b->lastMove + i);
+        __m512i opp = _mm512_add_epi32(_mm512_xor_si512(_mm512_sub_epi32(a, one), one), one);
+        __mmask16 reject = _mm512_cmpeq_epi32_mask(a, zero) | _mm512_cmpeq_epi32_mask(opp, last);
+        d = _mm512_mask_blend_epi32(reject, a, d);
+        _mm512_storeu_si512(b->dir + i, d);
+
+        __m512i x = _mm512_loadu_si512(b->headX + i);
+        __m512i y = _mm512_loadu_si512(b->headY + i);
+        x = _mm512_mask_sub_epi32(x, _mm512_cmpeq_epi32_mask(d, left), x, one);
+        x = _mm512_mask_add_epi32(x, _mm512_cmpeq_epi32_mask(d, right), x, one);
+        y = _mm512_mask_sub_epi32(y, _mm512_cmpeq_epi32_mask(d, up), y, one);
+        y = _mm512_mask_add_epi32(y, _mm512_cmpeq_epi32_mask(d, down), y, one);
+        x = _mm512_mask_mov_epi32(x, _mm512_cmplt_epi32_mask(x, zero), wLast);
+        x = _mm512_mask_mov_epi32(x, _mm512_cmpeq_epi32_mask(x, w), zero);
+        y = _mm512_mask_mov_epi32(y, _mm512_cmplt_epi32_mask(y, zero), hLast);
+        y = _mm512_mask_mov_epi32(y, _mm512_cmpeq_epi32_mask(y, h), zero);
+        _mm512_storeu_si512(b->nextX + i, x);
+        _mm512_storeu_si512(b->nextY + i, y);
+
+        __mmask16 onFood = _mm512_cmpeq_epi32_mask(x, _mm512_loadu_si512(b->foodX + i)) &
+                           _mm512_cmpeq_epi32_mask(y, _mm512_loadu_si512(b->foodY + i)) &
+                           _mm512_cmpneq_epi32_mask(d, zero);
+        _mm512_storeu_si512(b->grow + i, _mm512_maskz_mov_epi32(onFood, allOnes));
+    }
+    MoveKernelScalar(b, actions, i, end);
+}
+#endif
+
+typedef void (*MoveKernel)(SnakeBatch *b, const uint8_t *actions, int start, int end);
+
+static const struct {
+    const char *name;
+    MoveKernel run;
+} kernels[] = {
+    { "scalar", MoveKernelScalar },
+#ifdef BATCH_X86
+    { "sse4.1", MoveKernelSse41 },
+    { "avx2", MoveKernelAvx2 },
+    { "avx512", MoveKernelAvx512 },
+#endif
+};
+
+#define KERNEL_COUNT (int)(sizeof(kernels) / sizeof(kernels[0]))
+
+// --- Whether this CPU can run kernel k ---
+static bool KernelSupported(int k) {
+#ifdef BATCH_X86
+    __builtin_cpu_init();
+    if (k == 1) return __builtin_cpu_supports("sse4.1");
+    if (k == 2) return __builtin_cpu_supports("avx2");
+    if (k == 3) return __builtin_cpu_supports("avx512f");
+#endif
+    return k == 0;
+}
+
+// --- Pick the widest kernel for this CPU, honouring SNAKE_SIMD if it names one it runs ---
+static int SelectKernel(void) {
+    const char *forced = getenv("SNAKE_SIMD");
+    if (forced != NULL) {
+        for (int k = 0; k < KERNEL_COUNT; k++) {
+            if (strcmp(forced, kernels[k].name) == 0 && KernelSupported(k)) {
+                return k;
+            }
+        }
+    }
+    int k = KERNEL_COUNT - 1;
+    while (!KernelSupported(k)) {
+        k--;
+    }
+    return k;
+}
+
+const char *SnakeBatchKernelName(const SnakeBatch *batch) {
+    return kernels[batch->kernel].name;
+}
+
+SnakeBatch *SnakeBatchCreate(int count, int width, int height, uint64_t firstSeed) {
+    if (count < 1 || width < 1 || height < 1) {
+        return NULL;
+    }
+    size_t n = (size_t)count;
+    size_t cells = (size_t)width * height;
+    size_t lanes32 = AlignUp(n * sizeof(int32_t));
+    size_t total = AlignUp(sizeof(SnakeBatch)) + 16 * lanes32 +
+                   AlignUp(n * sizeof(uint32_t)) + AlignUp(n * sizeof(uint64_t)) +
+                   AlignUp(n * sizeof(SnakeRng)) +
+                   3 * AlignUp(n * cells * sizeof(int)) + AlignUp(n * cells);
+
+    char *p = aligned_alloc(BATCH_ALIGN, total);
+    if (p == NULL) {
+        return NULL;
+    }
+    SnakeBatch *b = Carve(&p, sizeof(SnakeBatch));
+    memset(b, 0, sizeof(*b));
+    b->count = count;
+    b->width = width;
+    b->height = height;
+    b->cells = (int)cells;
+    b->headX = Carve(&p, n * sizeof(int32_t));
+    b->headY = Carve(&p, n * sizeof(int32_t));
+    b->foodX = Carve(&p, n * sizeof(int32_t));
+    b->foodY = Carve(&p, n * sizeof(int32_t));
+    b->dir = Carve(&p, n * sizeof(int32_t));
+    b->lastMove = Carve(&p, n * sizeof(int32_t));
+    b->nTail = Carve(&p, n * sizeof(int32_t));
+    b->tailStart = Carve(&p, n * sizeof(int32_t));
+    b->nFree = Carve(&p, n * sizeof(int32_t));
+    b->score = Carve(&p, n * sizeof(int32_t));
+    b->ticks = Carve(&p, n * sizeof(uint32_t));
+    b->seed = Carve(&p, n * sizeof(uint64_t));
+    b->rng = Carve(&p, n * sizeof(SnakeRng));
+    b->nextX = Carve(&p, n * sizeof(int32_t));
+    b->nextY = Carve(&p, n * sizeof(int32_t));
+    b->grow = Carve(&p, n * sizeof(int32_t));
+    b->prevHead = Carve(&p, n * sizeof(int32_t));
+    b->vacated = Carve(&p, n * sizeof(int32_t));
+    b->placedFood = Carve(&p, n * sizeof(int32_t));
+    b->kernel = SelectKernel();
+    b->tail = Carve(&p, n * cells * sizeof(int));
+    b->freeCells = Carve(&p, n * cells * sizeof(int));
+    b->freePos = Carve(&p, n * cells * sizeof(int));
+    b->occupied = Carve(&p, n * cells);
+
+    for (int i = 0; i < count; i++) {
+        SnakeBatchResetLane(b, i, firstSeed + (uint64_t)i);
+    }
+    b->nextSeed = firstSeed + (uint64_t)count;
+    return b;
+}
+
+void SnakeBatchDestroy(SnakeBatch *batch) {
+    free(batch);
+}
+
+// --- Place food on a uniformly chosen free cell of one lane ---
+static int PlaceFood(SnakeBatch *b, int i) {
+    if (b->nFree[i] == 0) {
+        b->foodX[i] = b->foodY[i] = -1;
+        return -1;
+    }
+    const int *freeCells = b->freeCells + (size_t)i * b->cells;
+    int cell = freeCells[SnakeRngBounded(&b->rng[i], (uint32_t)b->nFree[i])];
+    b->foodX[i] = cell % b->width;
+    b->foodY[i] = cell / b->width;
+    return cell;
+}
+
+// --- Start a new game in one lane, exactly as SnakeReset() would ---
+void SnakeBatchResetLane(SnakeBatch *b, int i, uint64_t seed) {
+    size_t base = (size_t)i * b->cells;
+    b->seed[i] = seed;
+    SnakeRngSeed(&b->rng[i], seed);
+    b->dir[i] = STOP;
+    b->lastMove[i] = STOP;
+    b->headX[i] = b->width / 2;
+    b->headY[i] = b->height / 2;
+    b->score[i] = 0;
+    b->ticks[i] = 0;
+    b->nTail[i] = 0;
+    b->tailStart[i] = 0;
+    CellSetClear(b->freeCells + base, b->freePos + base, b->occupied + base,
+                 &b->nFree[i], b->cells);
+    CellSetOccupy(b->freeCells + base, b->freePos + base, b->occupied + base,
+                  &b->nFree[i], b->headY[i] * b->width + b->headX[i]);
+    PlaceFood(b, i);
+}
+
+// --- Finish one lane's tick after the move kernel; returns SNAKE_EVENT_* bits ---
+// Only the body ring and free-cell index are touched here, one lane at a time.
+static unsigned StepLane(SnakeBatch *b, int i, int32_t *reward) {
+    b->prevHead[i] = b->vacated[i] = b->placedFood[i] = -1;
+    if (b->dir[i] == STOP) {
+        return 0;
+    }
+
+    int w = b->width;
+    int x = b->nextX[i];
+    int y = b->nextY[i];
+    size_t base = (size_t)i * b->cells;
+    int *tail = b->tail + base;
+    int *freeCells = b->freeCells + base;
+    int *freePos = b->freePos + base;
+    unsigned char *occupied = b->occupied + base;
+    int oldHead = b->headY[i] * w + b->headX[i];
+    int newHead = y * w + x;
+    bool grow = b->grow[i] != 0;
+
+    if (!grow) {
+        int back = b->nTail[i] > 0
+                       ? tail[(b->tailStart[i] + b->nTail[i] - 1) % b->cells]
+                       : oldHead;
+        CellSetRelease(freeCells, freePos, occupied, &b->nFree[i], back);
+        b->vacated[i] = back;
+    }
+    if (b->nTail[i] > 0 || grow) {
+        b->tailStart[i] = (b->tailStart[i] + b->cells - 1) % b->cells;
+        tail[b->tailStart[i]] = oldHead;
+    }
+    if (grow) {
+        b->nTail[i]++;
+    }
+    b->prevHead[i] = oldHead;
+    b->headX[i] = x;
+    b->headY[i] = y;
+    b->lastMove[i] = b->dir[i];
+    b->ticks[i]++;
+
+    if (occupied[newHead]) {
+        return SNAKE_EVENT_MOVED | SNAKE_EVENT_DIED;
+    }
+    CellSetOccupy(freeCells, freePos, occupied, &b->nFree[i], newHead);
+
+    if (!grow) {
+        return SNAKE_EVENT_MOVED;
+    }
+    b->score[i] += SNAKE_FOOD_SCORE;
+    *reward = SNAKE_FOOD_SCORE;
+    b->placedFood[i] = PlaceFood(b, i);
+    if (b->placedFood[i] < 0) {
+        return SNAKE_EVENT_MOVED | SNAKE_EVENT_ATE | SNAKE_EVENT_WON;
+    }
+    return SNAKE_EVENT_MOVED | SNAKE_EVENT_ATE;
+}
+
+void SnakeBatchStep(SnakeBatch *b, const uint8_t *actions,
+                    int32_t *rewards, uint8_t *dones, uint32_t *events) {
+    kernels[b->kernel].run(b, actions, 0, b->count);
+    for (int i = 0; i < b->count; i++) {
+        rewards[i] = 0;
+        unsigned ev = StepLane(b, i, &rewards[i]);
+        bool done = (ev & (SNAKE_EVENT_DIED | SNAKE_EVENT_WON)) != 0;
+        dones[i] = done;
+        if (events != NULL) {
+            events[i] = ev;
+        }
+        if (done) {
+            SnakeBatchResetLane(b, i, b->nextSeed++);
+        }
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef SNAKE_BATCH_H
+#define SNAKE_BATCH_H
+
+#include <stdint.h>
+
+#include "engine.h"
+
+// --- Batched Snake Environment ---
+// Steps many independent games per call for RL training. The per-game
+// fields are stored as struct-of-arrays, so lane i of every array belongs
+// to game i and a pass over one field touches contiguous memory. Each lane
+// plays exactly the same rules as SnakeStep(): a lane reset with seed s
+// gives the same game as SnakeReset(game, s) fed the same actions.
+
+typedef struct SnakeBatch {
+    int count;                // Number of games (lanes)
+    int width, height, cells;
+    uint64_t nextSeed;        // Seed for the next auto-reset
+
+    // Hot per-game state, one entry per lane
+    int32_t *headX, *headY;
+    int32_t *foodX, *foodY;   // -1 when there is no food (board full)
+    int32_t *dir;             // enum eDirection of the next move
+    int32_t *lastMove;        // enum eDirection of the last move
+    int32_t *nTail;           // Body segments behind the head
+    int32_t *tailStart;       // Ring index of the segment right behind the head
+    int32_t *nFree;           // Number of free cells
+    int32_t *score;
+    uint32_t *ticks;          // Moves since the lane was last reset
+    uint64_t *seed;           // Seed each lane was last reset with
+    SnakeRng *rng;
+
+    // Scratch filled by the move kernel at the start of every step
+    int32_t *nextX, *nextY;   // Where each head moves to
+    int32_t *grow;            // -1 where the head lands on the food, else 0
+    int kernel;               // Move kernel picked for this CPU, see below
+
+    // What the last step changed in each lane, -1 where nothing did.
+    // Lanes that finished were reset afterwards and report done instead.
+    int32_t *prevHead;        // Cell the head left
+    int32_t *vacated;         // Cell the tail left
+    int32_t *placedFood;      // Cell new food was placed on
+
+    // Per-game bodies: lane i owns entries [i * cells, (i + 1) * cells)
+    int *tail;                // Ring of body cells
+    int *freeCells;           // Cells not covered by the snake
+    int *freePos;             // Slot of each cell in freeCells, -1 if covered
+    unsigned char *occupied;  // 1 for each covered cell
+} SnakeBatch;
+
+// --- Lifetime ---
+// Lanes are reset with seeds firstSeed, firstSeed + 1, ...; finished games
+// are reset automatically with the seeds that follow.
+SnakeBatch *SnakeBatchCreate(int count, int width, int height, uint64_t firstSeed);
+void SnakeBatchDestroy(SnakeBatch *batch);
+void SnakeBatchResetLane(SnakeBatch *batch, int lane, uint64_t seed);
+
+// --- Step every game once ---
+// actions[i] is the enum eDirection for lane i (STOP keeps going straight).
+// rewards[i] and dones[i] receive the outcome. Any lane that finishes is
+// reset before returning, so its state is already the start of a new game.
+// events may be NULL; otherwise it receives the SNAKE_EVENT_* bits.
+void SnakeBatchStep(SnakeBatch *batch, const uint8_t *actions,
+                    int32_t *rewards, uint8_t *dones, uint32_t *events);
+
+// --- Move kernel ---
+// Steering, the head move, the wrap-around and the food test run across
+// lanes with SIMD; the body update after them is scalar per lane. The
+// widest of AVX-512, AVX2 and SSE4.1 the CPU supports is picked when the
+// batch is created, or the one named by the SNAKE_SIMD environment
+// variable (avx512, avx2, sse4.1 or scalar) if the CPU supports it.
+const char *SnakeBatchKernelName(const SnakeBatch *batch);
+
+#endif
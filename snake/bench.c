@@ -0,0 +1,131 @@
+#define _POSIX_C_SOURCE 199309L // For clock_gettime()
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "batch.h"
+#include "obs.h"
+
+// --- Batch throughput benchmark ---
+// Steps a batch of games with random actions on one core and reports
+// env-steps per second. Usage: bench [games] [steps] [width] [height] [u8|f32]
+// With an observation type it also keeps planes, crops and rays current
+// after every step, reports what that costs, and checks the result against
+// a full rewrite into a second set of buffers.
+
+#define CROP_RADIUS 5
+
+static double Seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// --- One set of observation buffers ---
+typedef struct {
+    void *planes, *crops;
+    float *rays;
+    SnakeObs *obs;
+} Buffers;
+
+static void *AlignedAlloc(size_t size) {
+    return aligned_alloc(SNAKE_OBS_ALIGN, (size + SNAKE_OBS_ALIGN - 1) & ~(size_t)(SNAKE_OBS_ALIGN - 1));
+}
+
+static bool BuffersCreate(Buffers *b, const SnakeBatch *batch, SnakeObsType type) {
+    b->planes = AlignedAlloc(SnakeObsPlanesSize(batch, type));
+    b->crops = AlignedAlloc(SnakeObsCropsSize(batch, type, CROP_RADIUS));
+    b->rays = AlignedAlloc(SnakeObsRaysSize(batch));
+    b->obs = b->planes && b->crops && b->rays
+           ? SnakeObsCreate(batch, type, b->planes, b->crops, CROP_RADIUS, b->rays) : NULL;
+    return b->obs != NULL;
+}
+
+static void BuffersFree(Buffers *b) {
+    SnakeObsDestroy(b->obs);
+    free(b->planes);
+    free(b->crops);
+    free(b->rays);
+}
+
+// --- Whether two sets hold the same bytes ---
+static bool BuffersEqual(const Buffers *a, const Buffers *b, const SnakeBatch *batch, SnakeObsType type) {
+    return memcmp(a->planes, b->planes, SnakeObsPlanesSize(batch, type)) == 0 &&
+           memcmp(a->crops, b->crops, SnakeObsCropsSize(batch, type, CROP_RADIUS)) == 0 &&
+           memcmp(a->rays, b->rays, SnakeObsRaysSize(batch)) == 0;
+}
+
+int main(int argc, char *argv[]) {
+    int games = argc > 1 ? atoi(argv[1]) : 4096;
+    long steps = argc > 2 ? atol(argv[2]) : 2000;
+    int width = argc > 3 ? atoi(argv[3]) : 40;
+    int height = argc > 4 ? atoi(argv[4]) : 20;
+    const char *obsType = argc > 5 ? argv[5] : NULL;
+    if (obsType != NULL && strcmp(obsType, "u8") != 0 && strcmp(obsType, "f32") != 0) {
+        fprintf(stderr, "Usage: %s [games] [steps] [width] [height] [u8|f32]\n", argv[0]);
+        return 1;
+    }
+    SnakeObsType type = obsType != NULL && strcmp(obsType, "f32") == 0 ? SNAKE_OBS_F32 : SNAKE_OBS_U8;
+
+    SnakeBatch *batch = SnakeBatchCreate(games, width, height, 1);
+    uint8_t *actions = malloc((size_t)games);
+    int32_t *rewards = malloc((size_t)games * sizeof(int32_t));
+    uint8_t *dones = malloc((size_t)games);
+    if (batch == NULL || actions == NULL || rewards == NULL || dones == NULL) {
+        fprintf(stderr, "Out of memory for %d games\n", games);
+        return 1;
+    }
+    Buffers live = { 0 }, check = { 0 };
+    if (obsType != NULL && !BuffersCreate(&live, batch, type)) {
+        fprintf(stderr, "Out of memory for %d observations\n", games);
+        return 1;
+    }
+
+    SnakeRng rng;
+    SnakeRngSeed(&rng, 42);
+    long finished = 0;
+    double obsTime = 0;
+    double start = Seconds();
+    for (long s = 0; s < steps; s++) {
+        for (int i = 0; i < games; i++) {
+            actions[i] = (uint8_t)(SnakeRngNext(&rng) >> 62) + LEFT; // Random turn
+        }
+        SnakeBatchStep(batch, actions, rewards, dones, NULL);
+        if (live.obs != NULL) {
+            double before = Seconds();
+            SnakeObsUpdate(live.obs, batch, dones);
+            obsTime += Seconds() - before;
+        }
+        for (int i = 0; i < games; i++) {
+            finished += dones[i];
+        }
+    }
+    double elapsed = Seconds() - start;
+
+    printf("%d games x %ld steps on %dx%d (%s kernel): %.3fs, %.2fM env-steps/s, %ld games finished\n",
+           games, steps, width, height, SnakeBatchKernelName(batch), elapsed,
+           games * (double)steps / elapsed / 1e6, finished);
+
+    int status = 0;
+    if (live.obs != NULL) {
+        printf("%s observations: %.3fs of that, %.2fM updates/s\n",
+               obsType, obsTime, games * (double)steps / obsTime / 1e6);
+        // Creating the second set writes it in full from the final state
+        if (!BuffersCreate(&check, batch, type)) {
+            fprintf(stderr, "Out of memory for %d observations\n", games);
+            status = 1;
+        } else if (!BuffersEqual(&live, &check, batch, type)) {
+            fprintf(stderr, "Updated observations differ from a full rewrite\n");
+            status = 1;
+        }
+        BuffersFree(&live);
+        BuffersFree(&check);
+    }
+
+    SnakeBatchDestroy(batch);
+    free(actions);
+    free(rewards);
+    free(dones);
+    return status;
+}
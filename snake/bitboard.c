@@ -0,0 +1,401 @@
+#include "bitboard.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BITBOARD_X86 1
+#include <immintrin.h>
+#endif
+
+#define BITBOARD_ALIGN 64
+
+// --- Layout ---
+// Every set is padded with zero words on both sides, wider than the
+// largest shift, so the layer loop reads its neighbours without bounds
+// checks. A set pointer addresses its first real word.
+static int Pad(int words) {
+    return (words + 1 + 7) & ~7; // Whole cache lines of padding
+}
+
+static size_t SetStride(int words) {
+    return (size_t)(((words + 7) & ~7) + 2 * Pad(words)); // Keeps every set cache-line aligned
+}
+
+// --- Word i of set s moved k cells up (towards higher cells) or down ---
+// The double shift keeps k % 64 == 0 free of the undefined shift by 64.
+static inline uint64_t ShiftedUp(const uint64_t *s, int i, int k) {
+    int q = k >> 6;
+    int r = k & 63;
+    return (s[i - q] << r) | (s[i - q - 1] >> 1 >> (63 - r));
+}
+
+static inline uint64_t ShiftedDown(const uint64_t *s, int i, int k) {
+    int q = k >> 6;
+    int r = k & 63;
+    return (s[i + q] >> r) | (s[i + q + 1] << 1 << (63 - r));
+}
+
+// --- One BFS layer: next = neighbours(frontier) & open & ~seen; seen |= next ---
+// Returns nonzero if the layer reached any new cell.
+static uint64_t LayerScalar(SnakeBitboard *bb) {
+    const uint64_t *f = bb->frontier;
+    const uint64_t *open = bb->open;
+    const uint64_t *first = bb->firstColumn;
+    const uint64_t *last = bb->lastColumn;
+    uint64_t *next = bb->next;
+    uint64_t *seen = bb->seen;
+    int w = bb->width;
+    int wrapRow = (bb->height - 1) * w;
+    uint64_t wrap = bb->topology == SNAKE_TOPOLOGY_WRAP ? ~0ULL : 0;
+    uint64_t any = 0;
+
+    for (int i = 0; i < bb->words; i++) {
+        uint64_t n = (ShiftedUp(f, i, 1) & ~first[i]) |    // Right
+                     (ShiftedDown(f, i, 1) & ~last[i]) |   // Left
+                     ShiftedUp(f, i, w) |                  // Down
+                     ShiftedDown(f, i, w);                 // Up
+        n |= wrap & ((ShiftedDown(f, i, w - 1) & first[i]) | // Right off the last column
+                     (ShiftedUp(f, i, w - 1) & last[i]) |    // Left off the first column
+                     ShiftedDown(f, i, wrapRow) |            // Down off the last row
+                     ShiftedUp(f, i, wrapRow));              // Up off the first row
+        n &= open[i] & ~seen[i];
+        next[i] = n;
+        seen[i] |= n;
+        any |= n;
+    }
+    return any;
+}
+
+#ifdef BITBOARD_X86
+// --- The same layer across 4 (AVX2) or 8 (AVX-512) words at a time ---
+// A shift by k cells loads each lane's two source words unaligned, so the
+// carry from the neighbouring word is just the other load shifted the
+// other way. Shift counts of 64 give zero in these instructions, so k % 64
+// == 0 needs no special case. The loops run to a whole vector past the
+// last word: the padding of open is zero, so those lanes stay empty.
+typedef struct {
+    int q;                    // Whole words
+    __m128i r, l;             // Bit shift within a word, and its complement
+} Shift;
+
+static inline Shift MakeShift(int k) {
+    return (Shift){ k >> 6, _mm_cvtsi32_si128(k & 63), _mm_cvtsi32_si128(64 - (k & 63)) };
+}
+
+__attribute__((target("avx2")))
+static inline __m256i Up4(const uint64_t *s, int i, Shift sh) {
+    __m256i a = _mm256_loadu_si256((const __m256i *)(s + i - sh.q));
+    __m256i b = _mm256_loadu_si256((const __m256i *)(s + i - sh.q - 1));
+    return _mm256_or_si256(_mm256_sll_epi64(a, sh.r), _mm256_srl_epi64(b, sh.l));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i Down4(const uint64_t *s, int i, Shift sh) {
+    __m256i a = _mm256_loadu_si256((const __m256i *)(s + i + sh.q));
+    __m256i b = _mm256_loadu_si256((const __m256i *)(s + i + sh.q + 1));
+    return _mm256_or_si256(_mm256_srl_epi64(a, sh.r), _mm256_sll_epi64(b, sh.l));
+}
+
+__attribute__((target("avx2")))
+static uint64_t LayerAvx2(SnakeBitboard *bb) {
+    const uint64_t *f = bb->frontier;
+    int w = bb->width;
+    Shift one = MakeShift(1), row = MakeShift(w), across = MakeShift(w - 1);
+    Shift wrapRow = MakeShift((bb->height - 1) * w);
+    __m256i wrap = _mm256_set1_epi64x(bb->topology == SNAKE_TOPOLOGY_WRAP ? -1 : 0);
+    __m256i any = _mm256_setzero_si256();
+
+    for (int i = 0; i < bb->words; i += 4) {
+        __m256i first = _mm256_load_si256((const __m256i *)(bb->firstColumn + i));
+        __m256i last = _mm256_load_si256((const __m256i *)(bb->lastColumn + i));
+        __m256i n = _mm256_or_si256(_mm256_or_si256(_mm256_andnot_si256(first, Up4(f, i, one)),
+                                                    _mm256_andnot_si256(last, Down4(f, i, one))),
+                                    _mm256_or_si256(Up4(f, i, row), Down4(f, i, row)));
+        __m256i around = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(Down4(f, i, across), first),
+                                                         _mm256_and_si256(Up4(f, i, across), last)),
+                                         _mm256_or_si256(Down4(f, i, wrapRow), Up4(f, i, wrapRow)));
+        n = _mm256_or_si256(n, _mm256_and_si256(wrap, around));
+        __m256i seen = _mm256_load_si256((const __m256i *)(bb->seen + i));
+        n = _mm256_andnot_si256(seen, _mm256_and_si256(n, _mm256_load_si256((const __m256i *)(bb->open + i))));
+        _mm256_store_si256((__m256i *)(bb->next + i), n);
+        _mm256_store_si256((__m256i *)(bb->seen + i), _mm256_or_si256(seen, n));
+        any = _mm256_or_si256(any, n);
+    }
+    return !_mm256_testz_si256(any, any);
+}
+
+__attribute__((target("avx512f")))
+static inline __m512i Up8(const uint64_t *s, int i, Shift sh) {
+    __m512i a = _mm512_loadu_si512(s + i - sh.q);
+    __m512i b = _mm512_loadu_si512(s + i - sh.q - 1);
+    return _mm512_or_si512(_mm512_sll_epi64(a, sh.r), _mm512_srl_epi64(b, sh.l));
+}
+
+__attribute__((target("avx512f")))
+static inline __m512i Down8(const uint64_t *s, int i, Shift sh) {
+    __m512i a = _mm512_loadu_si512(s + i + sh.q);
+    __m512i b = _mm512_loadu_si512(s + i + sh.q + 1);
+    return _mm512_or_si512(_mm512_srl_epi64(a, sh.r), _mm512_sll_epi64(b, sh.l));
+}
+
+__attribute__((target("avx512f")))
+static uint64_t LayerAvx512(SnakeBitboard *bb) {
+    const uint64_t *f = bb->frontier;
+    int w = bb->width;
+    Shift one = MakeShift(1), row = MakeShift(w), across = MakeShift(w - 1);
+    Shift wrapRow = MakeShift((bb->height - 1) * w);
+    __m512i wrap = _mm512_set1_epi64(bb->topology == SNAKE_TOPOLOGY_WRAP ? -1 : 0);
+    __m512i any = _mm512_setzero_si512();
+
+    for (int i = 0; i < bb->words; i += 8) {
+        __m512i first = _mm512_load_si512(bb->firstColumn + i);
+        __m512i last = _mm512_load_si512(bb->lastColumn + i);
+        __m512i n = _mm512_or_si512(_mm512_or_si512(_mm512_andnot_si512(first, Up8(f, i, one)),
+                                                    _mm512_andnot_si512(last, Down8(f, i, one))),
+                                    _mm512_or_si512(Up8(f, i, row), Down8(f, i, row)));
+        __m512i around = _mm512_or_si512(_mm512_or_si512(_mm512_and_si512(Down8(f, i, across), first),
+                                                         _mm512_and_si512(Up8(f, i, across), last)),
+                                         _mm512_or_si512(Down8(f, i, wrapRow), Up8(f, i, wrapRow)));
+        n = _mm512_or_si512(n, _mm512_and_si512(wrap, around));
+        __m512i seen = _mm512_load_si512(bb->seen + i);
+        n = _mm512_andnot_si512(seen, _mm512_and_si512(n, _mm512_load_si512(bb->open + i)));
+        _mm512_store_si512(bb->next + i, n);
+        _mm512_store_si512(bb->seen + i, _mm512_or_si512(seen, n));
+        any = _mm512_or_si512(any, n);
+    }
+    return _mm512_test_epi64_mask(any, any) != 0;
+}
+#endif
+
+typedef uint64_t (*LayerKernel)(SnakeBitboard *bb);
+
+static const struct {
+    const char *name;
+    LayerKernel run;
+} kernels[] = {
+    { "scalar", LayerScalar },
+#ifdef BITBOARD_X86
+    { "avx2", LayerAvx2 },
+    { "avx512", LayerAvx512 },
+#endif
+};
+
+#define KERNEL_COUNT (int)(sizeof(kernels) / sizeof(kernels[0]))
+
+// --- Whether this CPU can run kernel k ---
+static bool KernelSupported(int k) {
+#ifdef BITBOARD_X86
+    __builtin_cpu_init();
+    if (k == 1) return __builtin_cpu_supports("avx2");
+    if (k == 2) return __builtin_cpu_supports("avx512f");
+#endif
+    return k == 0;
+}
+
+// --- Pick the widest kernel for this CPU, honouring SNAKE_SIMD if it names one it runs ---
+static int SelectKernel(void) {
+    const char *forced = getenv("SNAKE_SIMD");
+    if (forced != NULL) {
+        for (int k = 0; k < KERNEL_COUNT; k++) {
+            if (strcmp(forced, kernels[k].name) == 0 && KernelSupported(k)) {
+                return k;
+            }
+        }
+    }
+    int k = KERNEL_COUNT - 1;
+    while (!KernelSupported(k)) {
+        k--;
+    }
+    return k;
+}
+
+const char *SnakeBitboardKernelName(const SnakeBitboard *bb) {
+    return kernels[bb->kernel].name;
+}
+
+SnakeBitboard *SnakeBitboardCreate(int width, int height, SnakeTopology topology) {
+    if (width < 1 || height < 1) {
+        return NULL;
+    }
+    SnakeBitboard *bb = malloc(sizeof(SnakeBitboard));
+    if (bb == NULL) {
+        return NULL;
+    }
+    bb->width = width;
+    bb->height = height;
+    bb->cells = width * height;
+    bb->words = (bb->cells + 63) / 64;
+    bb->topology = topology;
+    bb->kernel = SelectKernel();
+
+    size_t stride = SetStride(bb->words);
+    size_t bytes = 6 * stride * sizeof(uint64_t);
+    bb->block = aligned_alloc(BITBOARD_ALIGN, bytes);
+    if (bb->block == NULL) {
+        free(bb);
+        return NULL;
+    }
+    memset(bb->block, 0, bytes);
+    uint64_t *sets[6];
+    for (int k = 0; k < 6; k++) {
+        sets[k] = (uint64_t *)bb->block + k * stride + Pad(bb->words);
+    }
+    bb->open = sets[0];
+    bb->firstColumn = sets[1];
+    bb->lastColumn = sets[2];
+    bb->frontier = sets[3];
+    bb->next = sets[4];
+    bb->seen = sets[5];
+
+    for (int y = 0; y < height; y++) {
+        SnakeBitboardSet(bb->firstColumn, y * width);
+        SnakeBitboardSet(bb->lastColumn, y * width + width - 1);
+    }
+    for (int cell = 0; cell < bb->cells; cell++) {
+        SnakeBitboardSet(bb->open, cell);
+    }
+    return bb;
+}
+
+void SnakeBitboardDestroy(SnakeBitboard *bb) {
+    if (bb != NULL) {
+        free(bb->block);
+        free(bb);
+    }
+}
+
+void SnakeBitboardLoad(SnakeBitboard *bb, const SnakeGame *g) {
+    const unsigned char *occupied = g->occupied;
+    for (int i = 0; i < bb->words; i++) {
+        int base = i * 64;
+        int n = bb->cells - base < 64 ? bb->cells - base : 64;
+        uint64_t word = 0;
+        for (int b = 0; b < n; b++) {
+            word |= (uint64_t)(occupied[base + b] == 0) << b;
+        }
+        bb->open[i] = word;
+    }
+}
+
+// --- Start a search: the frontier and seen sets hold only the start cell ---
+static void Begin(SnakeBitboard *bb, int start) {
+    size_t bytes = (size_t)bb->words * sizeof(uint64_t);
+    memset(bb->frontier, 0, bytes);
+    memset(bb->seen, 0, bytes);
+    SnakeBitboardSet(bb->frontier, start);
+    SnakeBitboardSet(bb->seen, start);
+}
+
+// --- Advance one layer; false once nothing new was reached ---
+static bool Advance(SnakeBitboard *bb) {
+    if (kernels[bb->kernel].run(bb) == 0) {
+        return false;
+    }
+    uint64_t *t = bb->frontier;
+    bb->frontier = bb->next;
+    bb->next = t;
+    return true;
+}
+
+// --- Flood fill along the rows inside one word, both ways ---
+// Kogge-Stone occluded fills: after k rounds every seed has spread 2^k
+// cells through open bits, never across a row boundary.
+static inline uint64_t RowFill(uint64_t seeds, uint64_t open, uint64_t first, uint64_t last) {
+    uint64_t right = seeds;
+    uint64_t pro = open & ~first;
+    for (int k = 1; k < 64; k <<= 1) {
+        right |= pro & (right << k);
+        pro &= pro << k;
+    }
+    uint64_t left = seeds;
+    pro = open & ~last;
+    for (int k = 1; k < 64; k <<= 1) {
+        left |= pro & (left >> k);
+        pro &= pro >> k;
+    }
+    return right | left;
+}
+
+// --- One in-place sweep of seen over every word, in either direction ---
+// Words already visited this sweep are read back updated, so a sweep
+// carries cells any distance in its direction, and whole runs along each
+// row at once. Returns nonzero if anything changed.
+static uint64_t FillSweep(SnakeBitboard *bb, bool up) {
+    const uint64_t *open = bb->open;
+    const uint64_t *first = bb->firstColumn;
+    const uint64_t *last = bb->lastColumn;
+    uint64_t *s = bb->seen;
+    int w = bb->width;
+    int wrapRow = (bb->height - 1) * w;
+    uint64_t wrap = bb->topology == SNAKE_TOPOLOGY_WRAP ? ~0ULL : 0;
+    uint64_t changed = 0;
+
+    for (int k = 0; k < bb->words; k++) {
+        int i = up ? k : bb->words - 1 - k;
+        uint64_t was = s[i];
+        uint64_t n = was;
+        uint64_t prev;
+        do { // Repeats only for rows that share this word
+            prev = n;
+            s[i] = n;
+            n |= ((ShiftedUp(s, i, 1) & ~first[i]) | (ShiftedDown(s, i, 1) & ~last[i]) |
+                  ShiftedUp(s, i, w) | ShiftedDown(s, i, w) |
+                  (wrap & ((ShiftedDown(s, i, w - 1) & first[i]) | (ShiftedUp(s, i, w - 1) & last[i]) |
+                           ShiftedDown(s, i, wrapRow) | ShiftedUp(s, i, wrapRow)))) & open[i];
+            n = RowFill(n, open[i], first[i], last[i]) | was;
+        } while (n != prev);
+        s[i] = n;
+        changed |= n ^ was;
+    }
+    return changed;
+}
+
+int SnakeBitboardReachable(SnakeBitboard *bb, int start, uint64_t *reached) {
+    // Sweeping down then up until nothing changes gives the same set as
+    // running BFS layers to the end, in far fewer passes.
+    Begin(bb, start);
+    while ((FillSweep(bb, true) | FillSweep(bb, false)) != 0) {
+    }
+    // seen holds the start, which counts only if it is open itself
+    int count = 0;
+    for (int i = 0; i < bb->words; i++) {
+        uint64_t word = bb->seen[i] & bb->open[i];
+        count += __builtin_popcountll(word);
+        if (reached != NULL) {
+            reached[i] = word;
+        }
+    }
+    return count;
+}
+
+int SnakeBitboardDistance(SnakeBitboard *bb, int start, int target) {
+    if (start == target) {
+        return 0;
+    }
+    Begin(bb, start);
+    for (int depth = 1; Advance(bb); depth++) {
+        if (SnakeBitboardTest(bb->frontier, target)) {
+            return depth;
+        }
+    }
+    return -1;
+}
+
+int SnakeBitboardLayers(SnakeBitboard *bb, int start, int *dist) {
+    for (int cell = 0; cell < bb->cells; cell++) {
+        dist[cell] = -1;
+    }
+    dist[start] = 0;
+    Begin(bb, start);
+    int depth = 0;
+    while (Advance(bb)) {
+        depth++;
+        for (int i = 0; i < bb->words; i++) {
+            for (uint64_t word = bb->frontier[i]; word != 0; word &= word - 1) {
+                dist[i * 64 + __builtin_ctzll(word)] = depth;
+            }
+        }
+    }
+    return depth;
+}
@@ -0,0 +1,41 @@
+#ifndef SNAKE_CELLSET_H
+#define SNAKE_CELLSET_H
+
+// --- Free-cell index shared by the engine and the batch environment ---
+// freeCells lists the cells the snake does not cover, in no particular
+// order, and freePos maps each cell to its slot there (-1 when covered).
+// occupied is the same information as one byte per cell for fast lookups.
+// All updates are O(1).
+
+// --- Fill the index with every cell free ---
+static inline void CellSetClear(int *freeCells, int *freePos, unsigned char *occupied,
+                                int *nFree, int cells) {
+    for (int i = 0; i < cells; i++) {
+        freeCells[i] = i;
+        freePos[i] = i;
+        occupied[i] = 0;
+    }
+    *nFree = cells;
+}
+
+// --- Mark a cell as covered by the snake and drop it from the free index ---
+static inline void CellSetOccupy(int *freeCells, int *freePos, unsigned char *occupied,
+                                 int *nFree, int cell) {
+    int pos = freePos[cell];
+    // Swap-remove: move the last free cell into the hole
+    int last = freeCells[--*nFree];
+    freeCells[pos] = last;
+    freePos[last] = pos;
+    freePos[cell] = -1;
+    occupied[cell] = 1;
+}
+
+// --- Mark a cell as no longer covered by the snake ---
+static inline void CellSetRelease(int *freeCells, int *freePos, unsigned char *occupied,
+                                  int *nFree, int cell) {
+    freePos[cell] = *nFree;
+    freeCells[(*nFree)++] = cell;
+    occupied[cell] = 0;
+}
+
+#endif
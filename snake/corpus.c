@@ -0,0 +1,348 @@
+#include "corpus.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CORPUS_MAGIC 0x3150524f434b4e53ULL // "SNKCORP1"
+#define ALIGN 64
+#define SIMULATE_CHUNK 64        // Games a build thread takes at a time
+#define FILTER_CHUNK (1 << 16)   // Games a filter thread takes at a time
+#define WRITE_BUFFER (1 << 20)
+
+// --- Columns, in file order ---
+enum { COL_SEED, COL_HASH, COL_MOVES_OFFSET, COL_MOVES_SIZE, COL_TICKS, COL_SCORE,
+       COL_WIDTH, COL_HEIGHT, COL_OUTCOME, COLUMNS };
+
+static const size_t columnSize[COLUMNS] = { 8, 8, 8, 4, 4, 4, 2, 2, 1 };
+
+typedef struct {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t count;
+    uint64_t columns[COLUMNS]; // File offset of each column
+    uint64_t movesStart;
+    uint64_t movesSize;
+} CorpusHeader;
+
+static uint64_t AlignUp(uint64_t n) {
+    return (n + ALIGN - 1) & ~(uint64_t)(ALIGN - 1);
+}
+
+// --- Run fn over [0, count) on every thread, chunk items at a time ---
+typedef struct {
+    void (*fn)(void *ctx, uint64_t start, uint64_t end);
+    void *ctx;
+    uint64_t count, chunk;
+    atomic_uint_fast64_t next;
+} ParallelJob;
+
+static void *ParallelWorker(void *arg) {
+    ParallelJob *job = arg;
+    for (;;) {
+        uint64_t start = atomic_fetch_add_explicit(&job->next, job->chunk, memory_order_relaxed);
+        if (start >= job->count) {
+            return NULL;
+        }
+        job->fn(job->ctx, start, start + job->chunk < job->count ? start + job->chunk : job->count);
+    }
+}
+
+static void ParallelFor(int threads, uint64_t count, uint64_t chunk,
+                        void (*fn)(void *, uint64_t, uint64_t), void *ctx) {
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    ParallelJob job = { fn, ctx, count, chunk, 0 };
+    pthread_t ids[threads > 1 ? threads - 1 : 1];
+    int started = 0;
+    for (; started < threads - 1; started++) {
+        if (pthread_create(&ids[started], NULL, ParallelWorker, &job) != 0) {
+            break; // Carry on with fewer threads
+        }
+    }
+    ParallelWorker(&job);
+    for (int k = 0; k < started; k++) {
+        pthread_join(ids[k], NULL);
+    }
+}
+
+// --- Build: replay every game to fill its summary ---
+typedef struct {
+    const SnakeReplay **games;
+    size_t gameSize;          // Enough for the largest board
+    uint64_t *seed, *hash;
+    uint32_t *ticks;
+    int32_t *score;
+    uint16_t *width, *height;
+    uint8_t *outcome;
+    atomic_bool failed;
+} Summary;
+
+static void SimulateChunk(void *ctx, uint64_t start, uint64_t end) {
+    Summary *s = ctx;
+    void *mem = malloc(s->gameSize);
+    if (mem == NULL) {
+        atomic_store(&s->failed, true);
+        return;
+    }
+    for (uint64_t i = start; i < end; i++) {
+        const SnakeReplay *r = s->games[i];
+        s->seed[i] = r->seed;
+        s->width[i] = (uint16_t)r->width;
+        s->height[i] = (uint16_t)r->height;
+        if ((uint64_t)r->width * (uint64_t)r->height > SNAKE_REPLAY_MAX_CELLS) {
+            s->outcome[i] = SNAKE_OUTCOME_INVALID; // Not simulated, so the rest of its row stays 0
+            continue;
+        }
+        SnakeGame *g = SnakeInit(mem, r->width, r->height);
+        SnakeReplayCursor cursor;
+        SnakeReplayStart(&cursor, r, g);
+        while (SnakeReplayStep(&cursor, g, NULL)) {
+        }
+        s->hash[i] = SnakeHash(g);
+        s->ticks[i] = SnakeTicks(g) < UINT32_MAX ? (uint32_t)SnakeTicks(g) : UINT32_MAX;
+        s->score[i] = SnakeScore(g);
+        if (!SnakeReplayMatches(r, g)) { // Including one cut short for stalling
+            s->outcome[i] = SNAKE_OUTCOME_INVALID;
+        } else if (SnakeIsWon(g)) {
+            s->outcome[i] = SNAKE_OUTCOME_WON;
+        } else if (SnakeIsOver(g)) {
+            s->outcome[i] = SNAKE_OUTCOME_DIED;
+        } else {
+            s->outcome[i] = SNAKE_OUTCOME_ABANDONED;
+        }
+    }
+    free(mem);
+}
+
+// --- Sequential writer for the move area ---
+typedef struct {
+    int fd;
+    bool failed;
+    size_t n;
+    uint8_t *buf;
+} Writer;
+
+static void WriterFlush(Writer *w) {
+    const uint8_t *p = w->buf;
+    while (w->n > 0 && !w->failed) {
+        ssize_t n = write(w->fd, p, w->n);
+        if (n <= 0) {
+            w->failed = true;
+            break;
+        }
+        p += n;
+        w->n -= (size_t)n;
+    }
+    w->n = 0;
+}
+
+static void WriterPut(Writer *w, const void *data, size_t len) {
+    const uint8_t *p = data;
+    while (len > 0) {
+        size_t room = WRITE_BUFFER - w->n;
+        size_t take = len < room ? len : room;
+        memcpy(w->buf + w->n, p, take);
+        w->n += take;
+        p += take;
+        len -= take;
+        if (w->n == WRITE_BUFFER) {
+            WriterFlush(w);
+        }
+    }
+}
+
+long long SnakeCorpusBuild(const char *path, SnakeReplayFile *const *files, int nFiles, int threads) {
+    uint64_t count = 0;
+    size_t gameSize = SnakeGameSize(1, 1);
+    uint64_t movesSize = 0;
+    for (int f = 0; f < nFiles; f++) {
+        for (int k = 0; k < files[f]->count; k++) {
+            const SnakeReplay *r = &files[f]->games[k];
+            if (r->width > UINT16_MAX || r->height > UINT16_MAX || r->dataSize > UINT32_MAX) {
+                return -1; // Does not fit the columns
+            }
+            if ((uint64_t)r->width * (uint64_t)r->height <= SNAKE_REPLAY_MAX_CELLS) {
+                size_t size = SnakeGameSize(r->width, r->height);
+                gameSize = size > gameSize ? size : gameSize;
+            }
+            movesSize += r->dataSize;
+            count++;
+        }
+    }
+
+    // Header, then each column, then the moves, all 64-byte aligned
+    CorpusHeader header = { CORPUS_MAGIC, SNAKE_CORPUS_VERSION, 0, count, { 0 }, 0, movesSize };
+    uint64_t offset = AlignUp(sizeof(CorpusHeader));
+    uint64_t columnsStart = offset;
+    for (int c = 0; c < COLUMNS; c++) {
+        header.columns[c] = offset;
+        offset = AlignUp(offset + count * columnSize[c]);
+    }
+    header.movesStart = offset;
+
+    uint8_t *columns = calloc(1, (size_t)(header.movesStart - columnsStart));
+    const SnakeReplay **games = malloc((count ? count : 1) * sizeof(*games));
+    uint8_t *buf = malloc(WRITE_BUFFER);
+    bool ok = columns != NULL && games != NULL && buf != NULL;
+    if (ok) {
+        uint64_t i = 0;
+        for (int f = 0; f < nFiles; f++) {
+            for (int k = 0; k < files[f]->count; k++) {
+                games[i++] = &files[f]->games[k];
+            }
+        }
+        #define COLUMN(c, type) ((type *)(columns + header.columns[c] - columnsStart))
+        Summary s = {
+            games, gameSize,
+            COLUMN(COL_SEED, uint64_t), COLUMN(COL_HASH, uint64_t), COLUMN(COL_TICKS, uint32_t),
+            COLUMN(COL_SCORE, int32_t), COLUMN(COL_WIDTH, uint16_t), COLUMN(COL_HEIGHT, uint16_t),
+            COLUMN(COL_OUTCOME, uint8_t), false,
+        };
+        ParallelFor(threads, count, SIMULATE_CHUNK, SimulateChunk, &s);
+        ok = !atomic_load(&s.failed);
+
+        uint64_t at = 0;
+        for (i = 0; i < count; i++) {
+            COLUMN(COL_MOVES_OFFSET, uint64_t)[i] = at;
+            COLUMN(COL_MOVES_SIZE, uint32_t)[i] = (uint32_t)games[i]->dataSize;
+            at += games[i]->dataSize;
+        }
+        #undef COLUMN
+    }
+
+    char temp[4096];
+    int len = snprintf(temp, sizeof(temp), "%s.%ld.tmp", path, (long)getpid());
+    int fd = ok && len > 0 && (size_t)len < sizeof(temp) ? open(temp, O_WRONLY | O_CREAT | O_TRUNC, 0644) : -1;
+    ok = ok && fd >= 0;
+    if (ok) {
+        Writer w = { fd, false, 0, buf };
+        uint8_t pad[ALIGN] = { 0 };
+        WriterPut(&w, &header, sizeof(header));
+        WriterPut(&w, pad, (size_t)(columnsStart - sizeof(header)));
+        WriterPut(&w, columns, (size_t)(header.movesStart - columnsStart));
+        for (uint64_t i = 0; i < count; i++) {
+            WriterPut(&w, games[i]->data, games[i]->dataSize);
+        }
+        WriterFlush(&w);
+        ok = !w.failed && fsync(fd) == 0;
+    }
+    if (fd >= 0) {
+        ok = close(fd) == 0 && ok;
+    }
+    if (ok) {
+        ok = rename(temp, path) == 0;
+    }
+    if (!ok && fd >= 0) {
+        unlink(temp);
+    }
+    free(columns);
+    free(games);
+    free(buf);
+    return ok ? (long long)count : -1;
+}
+
+SnakeCorpus *SnakeCorpusOpen(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    void *map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(CorpusHeader)) {
+        map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+    size_t size = (size_t)st.st_size;
+    const CorpusHeader *h = map;
+    bool ok = h->magic == CORPUS_MAGIC && h->version == SNAKE_CORPUS_VERSION &&
+              h->movesStart <= size && h->movesSize <= size - h->movesStart;
+    for (int c = 0; ok && c < COLUMNS; c++) {
+        ok = h->columns[c] % ALIGN == 0 && h->columns[c] <= size &&
+             h->count <= (size - h->columns[c]) / columnSize[c];
+    }
+    SnakeCorpus *corpus = ok ? malloc(sizeof(SnakeCorpus)) : NULL;
+    if (corpus == NULL) {
+        munmap(map, size);
+        return NULL;
+    }
+    const char *base = map;
+    corpus->count = h->count;
+    corpus->seed = (const uint64_t *)(base + h->columns[COL_SEED]);
+    corpus->hash = (const uint64_t *)(base + h->columns[COL_HASH]);
+    corpus->movesOffset = (const uint64_t *)(base + h->columns[COL_MOVES_OFFSET]);
+    corpus->movesSize = (const uint32_t *)(base + h->columns[COL_MOVES_SIZE]);
+    corpus->ticks = (const uint32_t *)(base + h->columns[COL_TICKS]);
+    corpus->score = (const int32_t *)(base + h->columns[COL_SCORE]);
+    corpus->width = (const uint16_t *)(base + h->columns[COL_WIDTH]);
+    corpus->height = (const uint16_t *)(base + h->columns[COL_HEIGHT]);
+    corpus->outcome = (const uint8_t *)(base + h->columns[COL_OUTCOME]);
+    corpus->moves = (const uint8_t *)(base + h->movesStart);
+    corpus->map = map;
+    corpus->size = size;
+
+    // Every game's bytes must lie inside the move area
+    for (uint64_t i = 0; i < corpus->count; i++) {
+        if (corpus->movesOffset[i] > h->movesSize ||
+            corpus->movesSize[i] > h->movesSize - corpus->movesOffset[i]) {
+            SnakeCorpusClose(corpus);
+            return NULL;
+        }
+    }
+    return corpus;
+}
+
+void SnakeCorpusClose(SnakeCorpus *corpus) {
+    if (corpus != NULL) {
+        munmap(corpus->map, corpus->size);
+        free(corpus);
+    }
+}
+
+SnakeCorpusQuery SnakeCorpusQueryAll(void) {
+    return (SnakeCorpusQuery){ INT64_MIN, INT64_MAX, 0, UINT64_MAX, 0, 0, ~0 };
+}
+
+// --- Filter: one pass per chunk, branch-free so it runs at memory speed ---
+typedef struct {
+    const SnakeCorpus *corpus;
+    const SnakeCorpusQuery *query;
+    uint8_t *matches;
+    atomic_uint_fast64_t found;
+} Filter;
+
+static void FilterChunk(void *ctx, uint64_t start, uint64_t end) {
+    Filter *f = ctx;
+    const SnakeCorpus *c = f->corpus;
+    const SnakeCorpusQuery *q = f->query;
+    uint64_t found = 0;
+    for (uint64_t i = start; i < end; i++) {
+        int match = (c->score[i] >= q->minScore) & (c->score[i] <= q->maxScore) &
+                    (c->ticks[i] >= q->minTicks) & (c->ticks[i] <= q->maxTicks) &
+                    ((q->width == 0) | (c->width[i] == q->width)) &
+                    ((q->height == 0) | (c->height[i] == q->height)) &
+                    ((q->outcomes >> c->outcome[i]) & 1);
+        f->matches[i] = (uint8_t)match;
+        found += (uint64_t)match;
+    }
+    atomic_fetch_add_explicit(&f->found, found, memory_order_relaxed);
+}
+
+uint64_t SnakeCorpusFilter(const SnakeCorpus *corpus, const SnakeCorpusQuery *query,
+                           uint8_t *matches, int threads) {
+    Filter f = { corpus, query, matches, 0 };
+    ParallelFor(threads, corpus->count, FILTER_CHUNK, FilterChunk, &f);
+    return atomic_load(&f.found);
+}
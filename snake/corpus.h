@@ -0,0 +1,84 @@
+#ifndef SNAKE_CORPUS_H
+#define SNAKE_CORPUS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "replay.h"
+
+// --- Replay Corpus ---
+// One file holding any number of replays, laid out to be queried straight
+// from mmap() without deserializing anything:
+//
+//   header    magic, version, game count and the offset of every column
+//   columns   one array per summary field, each 64-byte aligned, so a
+//             filter on score or ticks streams through contiguous memory
+//   moves     each game's replay bytes exactly as in a replay file, so
+//             extracting games is a copy and the result plays as it is
+//
+// Columns are in the byte order of the machine that built the file (the
+// magic does not match on the other order). SnakeCorpusBuild() replays
+// every game through the engine to find how it ended, so the summary
+// columns are trustworthy, and games whose replay disagrees with their
+// recorded result are kept but marked invalid. So are games on boards
+// over SNAKE_REPLAY_MAX_CELLS cells, which are not simulated, and games
+// cut short for going longer without eating than any real game (see
+// SnakeReplayStep()), so one hostile replay cannot stall a build.
+
+#define SNAKE_CORPUS_VERSION 1
+
+typedef enum {
+    SNAKE_OUTCOME_ABANDONED,  // Recording stopped with the snake alive
+    SNAKE_OUTCOME_DIED,       // Self-collision
+    SNAKE_OUTCOME_WON,        // Filled the board
+    SNAKE_OUTCOME_INVALID     // Unfinished, stalled or oversized, or the replay does not reproduce it
+} SnakeOutcome;
+
+typedef struct {
+    uint64_t count;           // Games
+    const uint64_t *seed;     // Columns, count entries each
+    const uint64_t *hash;     // Final SnakeHash()
+    const uint64_t *movesOffset; // Into moves
+    const uint32_t *movesSize;
+    const uint32_t *ticks;
+    const int32_t *score;
+    const uint16_t *width, *height;
+    const uint8_t *outcome;   // SnakeOutcome
+    const uint8_t *moves;     // Replay bytes of every game
+    void *map;
+    size_t size;
+} SnakeCorpus;
+
+// --- Build a corpus from the games of some replay files ---
+// Written to a temp file and renamed. threads <= 0 uses every core.
+// Returns the number of games written, or -1 on failure.
+long long SnakeCorpusBuild(const char *path, SnakeReplayFile *const *files, int nFiles, int threads);
+
+SnakeCorpus *SnakeCorpusOpen(const char *path); // NULL if missing or malformed
+void SnakeCorpusClose(SnakeCorpus *corpus);
+
+// --- Queries ---
+// Ranges are inclusive; a field left at its SnakeCorpusQueryAll() value
+// matches everything.
+typedef struct {
+    int64_t minScore, maxScore;
+    uint64_t minTicks, maxTicks;
+    int width, height;        // 0 for any size
+    int outcomes;             // Bit 1 << SnakeOutcome per accepted outcome
+} SnakeCorpusQuery;
+
+SnakeCorpusQuery SnakeCorpusQueryAll(void);
+
+// Sets matches[i] to 1 for every game i that matches, else 0, scanning
+// with threads threads (<= 0 for every core). Returns the match count.
+uint64_t SnakeCorpusFilter(const SnakeCorpus *corpus, const SnakeCorpusQuery *query,
+                           uint8_t *matches, int threads);
+
+// Replay bytes of game i, a valid replay file on their own
+static inline const uint8_t *SnakeCorpusGame(const SnakeCorpus *c, uint64_t i, size_t *size) {
+    *size = c->movesSize[i];
+    return c->moves + c->movesOffset[i];
+}
+
+#endif
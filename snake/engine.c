@@ -0,0 +1,239 @@
+#include "engine.h"
+#include "cellset.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// --- Storage layout: header, then the int arrays, then the byte arrays ---
+size_t SnakeGameSize(int width, int height) {
+    size_t cells = (size_t)width * height;
+    return sizeof(SnakeGame) + 3 * cells * sizeof(int) + cells;
+}
+
+// --- Point the array fields at the storage that follows the header ---
+static void BindStorage(SnakeGame *g) {
+    size_t cells = (size_t)g->cells;
+    char *p = (char *)(g + 1);
+    g->tail = (int *)p;      p += cells * sizeof(int);
+    g->freeCells = (int *)p; p += cells * sizeof(int);
+    g->freePos = (int *)p;   p += cells * sizeof(int);
+    g->occupied = (unsigned char *)p;
+}
+
+SnakeGame *SnakeInit(void *mem, int width, int height) {
+    SnakeGame *g = mem;
+    memset(g, 0, sizeof(*g));
+    g->width = width;
+    g->height = height;
+    g->cells = width * height;
+    BindStorage(g);
+    SnakeReset(g, 0);
+    return g;
+}
+
+SnakeGame *SnakeCreate(int width, int height) {
+    if (width < 1 || height < 1) {
+        return NULL;
+    }
+    void *mem = malloc(SnakeGameSize(width, height));
+    if (mem == NULL) {
+        return NULL;
+    }
+    return SnakeInit(mem, width, height);
+}
+
+void SnakeDestroy(SnakeGame *game) {
+    free(game);
+}
+
+// --- Clone: One memcpy of the whole block, then re-aim the array pointers ---
+// Copies everything, including the free-cell order, so the clone draws the
+// same food as the original would. See state.h for a compact checkpoint.
+void SnakeClone(SnakeGame *dst, const SnakeGame *src) {
+    memcpy(dst, src, SnakeGameSize(src->width, src->height));
+    BindStorage(dst);
+}
+
+// --- Mark a cell as covered by the snake ---
+static void OccupyCell(SnakeGame *g, int cell) {
+    CellSetOccupy(g->freeCells, g->freePos, g->occupied, &g->nFree, cell);
+}
+
+// --- Mark a cell as no longer covered by the snake ---
+static void ReleaseCell(SnakeGame *g, int cell) {
+    CellSetRelease(g->freeCells, g->freePos, g->occupied, &g->nFree, cell);
+}
+
+// --- Zobrist keys ---
+// Drawn from a mixing function (the splitmix64 finalizer) rather than
+// tables, so they need no board-sized memory and agree across processes.
+enum { KEY_HEAD = 1, KEY_FOOD, KEY_DIR, KEY_LAST, KEY_LINK };
+
+static uint64_t Key(uint64_t kind, uint64_t n) {
+    uint64_t z = (kind << 58) ^ n ^ 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Body segment at cell from, followed towards the head by cell to
+static uint64_t LinkKey(const SnakeGame *g, int from, int to) {
+    return Key(KEY_LINK, (uint64_t)from * (uint64_t)g->cells + (uint64_t)to);
+}
+
+static uint64_t FoodKey(const SnakeGame *g) {
+    return g->foodX < 0 ? 0 : Key(KEY_FOOD, (uint64_t)SnakeFoodCell(g));
+}
+
+uint64_t SnakeComputeHash(const SnakeGame *g) {
+    int head = SnakeHeadCell(g);
+    uint64_t h = Key(KEY_HEAD, (uint64_t)head) ^ FoodKey(g) ^
+                 Key(KEY_DIR, (uint64_t)g->dir) ^ Key(KEY_LAST, (uint64_t)g->lastMove);
+    int ahead = head;
+    for (int i = 0; i < g->nTail; i++) {
+        int cell = SnakeTailCell(g, i);
+        h ^= LinkKey(g, cell, ahead);
+        ahead = cell;
+    }
+    return h;
+}
+
+// --- Place food on a uniformly chosen free cell; returns the cell or -1 ---
+static int PlaceFood(SnakeGame *g) {
+    g->hash ^= FoodKey(g); // The old food is gone
+    if (g->nFree == 0) {
+        // The snake covers the whole board: nothing left to eat
+        g->foodX = g->foodY = -1;
+        g->gameWon = true;
+        g->gameOver = true;
+        return -1;
+    }
+    int cell = g->freeCells[SnakeRngBounded(&g->rng, (uint32_t)g->nFree)];
+    g->foodX = cell % g->width;
+    g->foodY = cell / g->width;
+    g->hash ^= FoodKey(g);
+    return cell;
+}
+
+// --- Reset: Start a new game with the snake in the middle of the board ---
+void SnakeReset(SnakeGame *g, uint64_t seed) {
+    g->seed = seed;
+    SnakeRngSeed(&g->rng, seed);
+    g->gameOver = false;
+    g->gameWon = false;
+    g->dir = STOP;
+    g->lastMove = STOP;
+    g->headX = g->width / 2;
+    g->headY = g->height / 2;
+    g->score = 0;
+    g->ticks = 0;
+    g->nTail = 0;
+    g->tailStart = 0;
+    CellSetClear(g->freeCells, g->freePos, g->occupied, &g->nFree, g->cells);
+    OccupyCell(g, SnakeHeadCell(g));
+    g->foodX = g->foodY = -1;
+    PlaceFood(g);
+    g->hash = SnakeComputeHash(g);
+}
+
+// --- Steer: Change direction unless it would turn back onto the neck ---
+// The check is against the last move made rather than the last accepted
+// steer, so two quick turns between ticks cannot reverse the snake.
+bool SnakeSteer(SnakeGame *g, enum eDirection d) {
+    if (d == STOP) {
+        return false;
+    }
+    if ((d == LEFT && g->lastMove == RIGHT) || (d == RIGHT && g->lastMove == LEFT) ||
+        (d == UP && g->lastMove == DOWN) || (d == DOWN && g->lastMove == UP)) {
+        return false;
+    }
+    g->hash ^= Key(KEY_DIR, (uint64_t)g->dir) ^ Key(KEY_DIR, (uint64_t)d);
+    g->dir = d;
+    return true;
+}
+
+void SnakeReseedFood(SnakeGame *g, uint64_t seed) {
+    SnakeRngSeed(&g->rng, seed);
+}
+
+// --- Step: Apply an action and advance the game by one tick ---
+// An action of STOP keeps the current direction. Nothing moves until the
+// game has a direction, and a finished game stays finished.
+SnakeStepResult SnakeStep(SnakeGame *g, enum eDirection action) {
+    SnakeStepResult r = { 0, g->gameOver, 0, -1, -1, -1 };
+    if (g->gameOver) {
+        return r;
+    }
+    SnakeSteer(g, action);
+    if (g->dir == STOP) {
+        return r; // Don't move if not started
+    }
+
+    // Calculate new head position, wrapping around the edges
+    int newHeadX = g->headX;
+    int newHeadY = g->headY;
+    switch (g->dir) {
+        case LEFT:  newHeadX = newHeadX == 0 ? g->width - 1 : newHeadX - 1; break;
+        case RIGHT: newHeadX = newHeadX == g->width - 1 ? 0 : newHeadX + 1; break;
+        case UP:    newHeadY = newHeadY == 0 ? g->height - 1 : newHeadY - 1; break;
+        case DOWN:  newHeadY = newHeadY == g->height - 1 ? 0 : newHeadY + 1; break;
+        default: break;
+    }
+    int newHead = newHeadY * g->width + newHeadX;
+    int oldHead = SnakeHeadCell(g);
+    bool grow = (newHeadX == g->foodX && newHeadY == g->foodY);
+
+    // The back of the snake leaves its cell unless we are growing. With no
+    // tail that is the head's own cell.
+    if (!grow) {
+        int back = oldHead;
+        if (g->nTail > 0) {
+            back = SnakeTailCell(g, g->nTail - 1);
+            g->hash ^= LinkKey(g, back, g->nTail > 1 ? SnakeTailCell(g, g->nTail - 2) : oldHead);
+        }
+        ReleaseCell(g, back);
+        r.vacatedCell = back;
+    }
+
+    // Push the old head onto the front of the ring. The back segment drops
+    // off on its own because nTail stays the same unless we are growing.
+    if (g->nTail > 0 || grow) {
+        g->tailStart = (g->tailStart + g->cells - 1) % g->cells;
+        g->tail[g->tailStart] = oldHead;
+        g->hash ^= LinkKey(g, oldHead, newHead);
+    }
+    if (grow) {
+        g->nTail++;
+    }
+
+    g->headX = newHeadX;
+    g->headY = newHeadY;
+    g->hash ^= Key(KEY_HEAD, (uint64_t)oldHead) ^ Key(KEY_HEAD, (uint64_t)newHead) ^
+               Key(KEY_LAST, (uint64_t)g->lastMove) ^ Key(KEY_LAST, (uint64_t)g->dir);
+    g->lastMove = g->dir;
+    g->ticks++;
+    r.events |= SNAKE_EVENT_MOVED;
+
+    // Check for self-collision
+    if (g->occupied[newHead]) {
+        g->gameOver = true;
+        r.done = true;
+        r.events |= SNAKE_EVENT_DIED;
+        return r;
+    }
+    OccupyCell(g, newHead);
+    r.enteredCell = newHead;
+
+    // Handle food eating
+    if (grow) {
+        g->score += SNAKE_FOOD_SCORE;
+        r.reward = SNAKE_FOOD_SCORE;
+        r.events |= SNAKE_EVENT_ATE;
+        r.foodCell = PlaceFood(g);
+        if (g->gameWon) {
+            r.done = true;
+            r.events |= SNAKE_EVENT_WON;
+        }
+    }
+    return r;
+}
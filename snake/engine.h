@@ -0,0 +1,131 @@
+#ifndef SNAKE_ENGINE_H
+#define SNAKE_ENGINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rng.h"
+
+// --- Headless Snake Engine ---
+// All game rules live here, with no terminal or global state, so the game
+// can be driven by the TUI, a bot or a simulator alike. Coordinates are
+// 0-based: x in [0, width), y in [0, height). A cell number is y * width + x.
+// The board wraps around at every edge.
+
+enum eDirection { STOP = 0, LEFT, RIGHT, UP, DOWN };
+
+// --- Events reported by SnakeStep() ---
+#define SNAKE_EVENT_MOVED 0x1 // The snake moved one cell
+#define SNAKE_EVENT_ATE   0x2 // The head reached the food
+#define SNAKE_EVENT_DIED  0x4 // The head ran into the body
+#define SNAKE_EVENT_WON   0x8 // The snake covers the whole board
+
+#define SNAKE_FOOD_SCORE 10 // Points for each food eaten
+
+typedef struct {
+    int reward;       // Points scored by this step
+    bool done;        // The game is over (died or won)
+    unsigned events;  // SNAKE_EVENT_* bits
+    int enteredCell;  // Cell the head moved into, or -1
+    int vacatedCell;  // Cell the tail left, or -1
+    int foodCell;     // Cell new food was placed on, or -1
+} SnakeStepResult;
+
+// --- Game state ---
+// Everything a game needs lives in one block: this header followed by the
+// arrays it points to, all sized from the board area when the game is
+// created. Nothing is allocated while playing. Treat the fields as
+// read-only outside engine.c and prefer the accessors below.
+typedef struct SnakeGame {
+    int width, height;
+    int cells;               // width * height
+    int headX, headY;
+    int foodX, foodY;        // -1 when there is no food (board full)
+    int score;
+    int nTail;               // Body segments behind the head
+    int tailStart;           // Ring index of the segment right behind the head
+    int nFree;               // Number of entries in freeCells
+    enum eDirection dir;     // Direction of the next move
+    enum eDirection lastMove; // Direction of the last move, STOP before the first
+    bool gameOver;
+    bool gameWon;            // Set together with gameOver when the board is full
+    unsigned long ticks;     // Moves made since the last reset
+    uint64_t seed;           // Seed passed to the last SnakeReset()
+    uint64_t hash;           // Zobrist hash of the position, see SnakeHash()
+    SnakeRng rng;            // Food placement; advanced only by this game
+    int *tail;               // Ring of body cells, one slot per board cell
+    int *freeCells;          // Cells not covered by the snake, in no particular order
+    int *freePos;            // Index of each cell in freeCells, or -1 if covered
+    unsigned char *occupied; // 1 for each cell covered by the head or body
+} SnakeGame;
+
+// --- Lifetime ---
+size_t SnakeGameSize(int width, int height);              // Bytes SnakeInit() needs
+SnakeGame *SnakeInit(void *mem, int width, int height);   // Build a game in caller memory
+SnakeGame *SnakeCreate(int width, int height);            // Allocate and build, NULL on failure
+void SnakeDestroy(SnakeGame *game);                       // Free a SnakeCreate() game
+void SnakeClone(SnakeGame *dst, const SnakeGame *src);    // Exact copy between same-size games
+
+// --- Playing ---
+// The same seed and the same sequence of actions always give the same game.
+void SnakeReset(SnakeGame *game, uint64_t seed);
+bool SnakeSteer(SnakeGame *game, enum eDirection dir);
+SnakeStepResult SnakeStep(SnakeGame *game, enum eDirection action);
+
+// Re-seed only where future food lands, leaving SnakeGame.seed alone. Search
+// rollouts use it so they cannot foresee the real game's food.
+void SnakeReseedFood(SnakeGame *game, uint64_t seed);
+
+// --- Position hash ---
+// A Zobrist hash of the head, the body in order (one key per link from a
+// segment to the one ahead of it), the food, the steering direction and
+// the last move. The RNG is not part of it. Every step updates it in O(1)
+// from what the step changed; SnakeComputeHash() rebuilds it from scratch.
+// Equal positions reached by different move orders hash equal, for
+// transposition tables, and two runs of the same game must agree on it
+// every tick, so it doubles as a desync checksum.
+uint64_t SnakeComputeHash(const SnakeGame *game);
+
+// --- Read-only accessors ---
+static inline int SnakeWidth(const SnakeGame *g) { return g->width; }
+static inline int SnakeHeight(const SnakeGame *g) { return g->height; }
+static inline int SnakeScore(const SnakeGame *g) { return g->score; }
+static inline int SnakeLength(const SnakeGame *g) { return g->nTail + 1; }
+static inline bool SnakeIsOver(const SnakeGame *g) { return g->gameOver; }
+static inline bool SnakeIsWon(const SnakeGame *g) { return g->gameWon; }
+static inline enum eDirection SnakeDirection(const SnakeGame *g) { return g->dir; }
+static inline unsigned long SnakeTicks(const SnakeGame *g) { return g->ticks; }
+static inline uint64_t SnakeHash(const SnakeGame *g) { return g->hash; }
+static inline int SnakeHeadCell(const SnakeGame *g) { return g->headY * g->width + g->headX; }
+static inline int SnakeFoodCell(const SnakeGame *g) {
+    return g->foodX < 0 ? -1 : g->foodY * g->width + g->foodX;
+}
+static inline bool SnakeCellOccupied(const SnakeGame *g, int cell) { return g->occupied[cell]; }
+
+// Cell reached by moving one step from cell in direction d, wrapping around
+static inline int SnakeNeighbor(const SnakeGame *g, int cell, enum eDirection d) {
+    int x = cell % g->width;
+    int y = cell / g->width;
+    switch (d) {
+        case LEFT:  x = x == 0 ? g->width - 1 : x - 1; break;
+        case RIGHT: x = x == g->width - 1 ? 0 : x + 1; break;
+        case UP:    y = y == 0 ? g->height - 1 : y - 1; break;
+        case DOWN:  y = y == g->height - 1 ? 0 : y + 1; break;
+        default: break;
+    }
+    return y * g->width + x;
+}
+
+// Direction that undoes d (STOP for STOP)
+static inline enum eDirection SnakeOpposite(enum eDirection d) {
+    static const enum eDirection opposite[] = { STOP, RIGHT, LEFT, DOWN, UP };
+    return opposite[d];
+}
+
+// Cell of body segment i, counting from 0 right behind the head
+static inline int SnakeTailCell(const SnakeGame *g, int i) {
+    return g->tail[(g->tailStart + i) % g->cells];
+}
+
+#endif
@@ -0,0 +1,308 @@
+#define _GNU_SOURCE // For sched_setaffinity() and CPU_SET
+#include "farm.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define CACHE_LINE 64
+#define DEFAULT_ITEMS_PER_THREAD 64 // Chunks per thread when no chunk size is given
+
+// --- A range of seeds [start, end) ---
+typedef struct {
+    uint64_t start, end;
+} WorkItem;
+
+// --- Chase-Lev work-stealing deque ---
+// The owner pushes and pops at the bottom; thieves take from the top with
+// a CAS. top and bottom sit on separate cache lines so thieves polling top
+// do not bounce the owner's line. The buffer never grows: every item is
+// pushed before the workers start and it is sized to hold them all.
+typedef struct {
+    _Alignas(CACHE_LINE) atomic_llong top;
+    _Alignas(CACHE_LINE) atomic_llong bottom;
+    _Alignas(CACHE_LINE) WorkItem *items;
+    long long mask;
+} Deque;
+
+enum { STEAL_OK, STEAL_EMPTY, STEAL_LOST_RACE };
+
+static void DequePush(Deque *d, WorkItem item) {
+    long long b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    d->items[b & d->mask] = item;
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+}
+
+static bool DequePop(Deque *d, WorkItem *item) {
+    long long b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long t = atomic_load_explicit(&d->top, memory_order_relaxed);
+    if (t > b) {
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        return false; // Empty
+    }
+    *item = d->items[b & d->mask];
+    if (t == b) {
+        // Last item: race any thief for it
+        bool won = atomic_compare_exchange_strong_explicit(
+            &d->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        return won;
+    }
+    return true;
+}
+
+static int DequeSteal(Deque *d, WorkItem *item) {
+    long long t = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+    if (t >= b) {
+        return STEAL_EMPTY;
+    }
+    WorkItem it = d->items[t & d->mask];
+    if (!atomic_compare_exchange_strong_explicit(
+            &d->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+        return STEAL_LOST_RACE;
+    }
+    *item = it;
+    return STEAL_OK;
+}
+
+// --- Per-thread state, one cache-line-aligned block per worker ---
+typedef struct Worker {
+    _Alignas(CACHE_LINE) Deque deque;
+    _Alignas(CACHE_LINE) SnakeFarmStats stats;
+    int id;
+    int count;                 // Number of workers
+    struct Worker *all;
+    const SnakeFarmConfig *config;
+    SnakeRng victims;          // Picks where to start stealing
+    pthread_t thread;
+    int failed;                // Could not allocate its game or policy state
+} Worker;
+
+// --- Pin the calling thread to one CPU, so its first-touch pages stay local ---
+static void PinToCpu(int cpu) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1) {
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % cpus, &set);
+    sched_setaffinity(0, sizeof(set), &set); // Best effort
+}
+
+// --- Take the next work item: own deque first, then steal ---
+static bool NextItem(Worker *w, WorkItem *item) {
+    if (DequePop(&w->deque, item)) {
+        return true;
+    }
+    // Nothing is pushed once the workers run, so a full pass that finds
+    // every deque empty means the work is done.
+    for (;;) {
+        bool sawWork = false;
+        int start = (int)SnakeRngBounded(&w->victims, (uint32_t)w->count);
+        for (int k = 0; k < w->count; k++) {
+            Worker *victim = &w->all[(start + k) % w->count];
+            if (victim == w) {
+                continue;
+            }
+            int r = DequeSteal(&victim->deque, item);
+            if (r == STEAL_OK) {
+                w->stats.steals++;
+                return true;
+            }
+            if (r == STEAL_LOST_RACE) {
+                sawWork = true;
+            }
+        }
+        if (!sawWork) {
+            return false;
+        }
+    }
+}
+
+// --- Play one game to the end and fold it into the thread's statistics ---
+static void PlayGame(Worker *w, SnakeGame *game, void *ctx, uint64_t seed) {
+    const SnakeFarmConfig *c = w->config;
+    SnakeFarmStats *s = &w->stats;
+
+    SnakeReset(game, seed);
+    while (!SnakeIsOver(game)) {
+        if (c->maxTicks != 0 && SnakeTicks(game) >= c->maxTicks) {
+            s->timeouts++;
+            break;
+        }
+        // STOP before the first move leaves the game where it is, and so
+        // would every later step: count it as a timeout rather than spin
+        SnakeStepResult r = SnakeStep(game, c->policy(game, ctx));
+        if (!(r.events & SNAKE_EVENT_MOVED) && !SnakeIsOver(game)) {
+            s->timeouts++;
+            break;
+        }
+    }
+
+    int score = SnakeScore(game);
+    s->games++;
+    s->wins += SnakeIsWon(game);
+    s->deaths += SnakeIsOver(game) && !SnakeIsWon(game);
+    s->ticks += SnakeTicks(game);
+    s->winTicks += SnakeIsWon(game) ? SnakeTicks(game) : 0;
+    s->totalScore += (uint64_t)score;
+    if (s->games == 1 || score < s->minScore) {
+        s->minScore = score;
+    }
+    if (s->games == 1 || score > s->maxScore) {
+        s->maxScore = score;
+        s->maxScoreSeed = seed;
+    }
+    int food = score / SNAKE_FOOD_SCORE;
+    int bucket = 0;
+    while (food > 0 && bucket < SNAKE_FARM_SCORE_BUCKETS - 1) {
+        food >>= 1;
+        bucket++;
+    }
+    s->foodHist[bucket]++;
+}
+
+static void *WorkerMain(void *arg) {
+    Worker *w = arg;
+    const SnakeFarmConfig *c = w->config;
+    PinToCpu(w->id);
+
+    // Allocated after pinning, so first touch places it on this CPU's node.
+    // Rounded to whole cache lines so no two threads share one.
+    size_t size = (SnakeGameSize(c->width, c->height) + CACHE_LINE - 1) & ~(size_t)(CACHE_LINE - 1);
+    void *mem = aligned_alloc(CACHE_LINE, size);
+    if (mem == NULL) {
+        w->failed = 1;
+        return NULL;
+    }
+    SnakeGame *game = SnakeInit(mem, c->width, c->height);
+    void *ctx = c->threadInit != NULL ? c->threadInit(c->policyCtx, w->id) : c->policyCtx;
+    if (c->threadInit != NULL && ctx == NULL) {
+        w->failed = 1; // The other threads steal its work
+        free(mem);
+        return NULL;
+    }
+
+    WorkItem item;
+    while (NextItem(w, &item)) {
+        for (uint64_t seed = item.start; seed < item.end; seed++) {
+            PlayGame(w, game, ctx, seed);
+        }
+    }
+
+    if (c->threadInit != NULL && c->threadFree != NULL) {
+        c->threadFree(ctx);
+    }
+    free(mem);
+    return NULL;
+}
+
+// --- Merge one thread's statistics into the totals ---
+static void MergeStats(SnakeFarmStats *into, const SnakeFarmStats *from) {
+    if (from->games == 0) {
+        into->steals += from->steals;
+        return;
+    }
+    if (into->games == 0 || from->minScore < into->minScore) {
+        into->minScore = from->minScore;
+    }
+    if (into->games == 0 || from->maxScore > into->maxScore) {
+        into->maxScore = from->maxScore;
+        into->maxScoreSeed = from->maxScoreSeed;
+    }
+    into->games += from->games;
+    into->wins += from->wins;
+    into->deaths += from->deaths;
+    into->timeouts += from->timeouts;
+    into->ticks += from->ticks;
+    into->winTicks += from->winTicks;
+    into->totalScore += from->totalScore;
+    into->steals += from->steals;
+    for (int i = 0; i < SNAKE_FARM_SCORE_BUCKETS; i++) {
+        into->foodHist[i] += from->foodHist[i];
+    }
+}
+
+int SnakeFarmRun(const SnakeFarmConfig *config, SnakeFarmStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    int threads = config->threads;
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    uint64_t chunk = config->chunk;
+    if (chunk == 0) {
+        chunk = config->games / ((uint64_t)threads * DEFAULT_ITEMS_PER_THREAD);
+        if (chunk == 0) chunk = 1;
+    }
+    uint64_t nItems = (config->games + chunk - 1) / chunk;
+
+    Worker *workers = aligned_alloc(CACHE_LINE, sizeof(Worker) * (size_t)threads);
+    if (workers == NULL) {
+        return -1;
+    }
+    memset(workers, 0, sizeof(Worker) * (size_t)threads);
+
+    // Give each worker a contiguous block of chunks to start from
+    int result = 0;
+    for (int k = 0; k < threads; k++) {
+        Worker *w = &workers[k];
+        uint64_t first = nItems * (uint64_t)k / (uint64_t)threads;
+        uint64_t last = nItems * (uint64_t)(k + 1) / (uint64_t)threads;
+        long long capacity = 1;
+        while ((uint64_t)capacity < last - first) capacity <<= 1;
+
+        w->id = k;
+        w->count = threads;
+        w->all = workers;
+        w->config = config;
+        SnakeRngSeed(&w->victims, (uint64_t)k);
+        atomic_init(&w->deque.top, 0);
+        atomic_init(&w->deque.bottom, 0);
+        w->deque.mask = capacity - 1;
+        w->deque.items = malloc(sizeof(WorkItem) * (size_t)capacity);
+        if (w->deque.items == NULL) {
+            result = -1;
+            continue;
+        }
+        // Pushed in reverse so the owner pops its seeds in increasing order
+        for (uint64_t it = last; it > first; it--) {
+            uint64_t start = config->firstSeed + (it - 1) * chunk;
+            uint64_t end = config->firstSeed + (it == nItems ? config->games : it * chunk);
+            DequePush(&w->deque, (WorkItem){ start, end });
+        }
+    }
+
+    int started = 0;
+    if (result == 0) {
+        for (; started < threads; started++) {
+            if (pthread_create(&workers[started].thread, NULL, WorkerMain, &workers[started]) != 0) {
+                result = -1;
+                break;
+            }
+        }
+    }
+    // Threads that did start steal whatever the missing ones would have run
+    for (int k = 0; k < started; k++) {
+        pthread_join(workers[k].thread, NULL);
+    }
+
+    for (int k = 0; k < threads; k++) {
+        if (workers[k].failed) {
+            result = -1;
+        }
+        MergeStats(stats, &workers[k].stats);
+        free(workers[k].deque.items);
+    }
+    free(workers);
+    return result;
+}
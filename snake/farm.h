@@ -0,0 +1,54 @@
+#ifndef SNAKE_FARM_H
+#define SNAKE_FARM_H
+
+#include <stdint.h>
+
+#include "engine.h"
+
+// --- Simulation Farm ---
+// Plays complete headless games for a range of seeds across a pool of
+// threads. Seeds are cut into chunks that sit in per-thread work-stealing
+// deques; a thread that runs out steals chunks from the others. Each thread
+// keeps its own statistics, merged once at the end, so the hot path takes
+// no locks and touches no shared cache lines.
+
+// --- Policy: pick the next action for a game ---
+// ctx is whatever threadInit returned for the calling thread (or the
+// config's policyCtx when threadInit is NULL). Returning STOP keeps going
+// straight.
+typedef enum eDirection (*SnakePolicy)(const SnakeGame *game, void *ctx);
+
+typedef struct {
+    int threads;              // Worker threads, 0 for one per online CPU
+    int width, height;        // Board size
+    uint64_t firstSeed;       // Games use seeds firstSeed .. firstSeed + games - 1
+    uint64_t games;
+    uint64_t chunk;           // Seeds handed out per work item, 0 for a default
+    unsigned long maxTicks;   // Stop a game after this many ticks, 0 for no limit
+
+    SnakePolicy policy;
+    void *policyCtx;
+    void *(*threadInit)(void *policyCtx, int thread); // Optional per-thread policy state, NULL on failure
+    void (*threadFree)(void *threadCtx);
+} SnakeFarmConfig;
+
+#define SNAKE_FARM_SCORE_BUCKETS 32 // Power-of-two buckets of food eaten
+
+typedef struct {
+    uint64_t games;
+    uint64_t wins;            // Filled the board
+    uint64_t deaths;          // Ran into the body
+    uint64_t timeouts;        // Hit maxTicks
+    uint64_t ticks;           // Summed over all games
+    uint64_t winTicks;        // Summed over won games: ticks to fill the board
+    uint64_t totalScore;
+    int minScore, maxScore;
+    uint64_t maxScoreSeed;    // Seed of the best game, for replaying it
+    uint64_t steals;          // Work items taken from another thread
+    uint64_t foodHist[SNAKE_FARM_SCORE_BUCKETS]; // Bucket i: food eaten in [2^(i-1), 2^i)
+} SnakeFarmStats;
+
+// --- Run every game of the config; returns 0, or -1 if threads or memory fail ---
+int SnakeFarmRun(const SnakeFarmConfig *config, SnakeFarmStats *stats);
+
+#endif
@@ -0,0 +1,383 @@
+#define _POSIX_C_SOURCE 199309L // For clock_gettime()
+#include "mcts.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CACHE_LINE 64
+#define DEFAULT_NODES (1 << 20)
+#define DEFAULT_ROLLOUT_DEPTH 40
+#define DEFAULT_EXPLORATION 1.0
+#define DEFAULT_VIRTUAL_LOSS 3
+#define MAX_DEPTH 256            // Longest path walked down a tree
+#define DISCOUNT 0.97            // Per-tick discount on rewards
+#define VALUE_SCALE 65536.0      // Node values are fixed point, for atomic adds
+#define CHECK_CLOCK_EVERY 16     // Simulations between deadline checks
+#define MIN_NODES 5              // The root and its four children
+
+#define CHILDREN_NONE 0u          // Leaf: never expanded (node 0 is the root, never a child)
+#define CHILDREN_BUSY 0xffffffffu // Being expanded by another thread
+#define CHILDREN_FULL 0xfffffffeu // Pool ran out: stays a leaf
+
+// --- Tree node: children are 4 consecutive nodes, one per direction ---
+typedef struct {
+    atomic_uint visits;       // Includes virtual visits of threads on the way down
+    atomic_uint children;     // Index of the LEFT child, or CHILDREN_*
+    atomic_llong value;       // Sum of returns, VALUE_SCALE units
+} Node;
+
+typedef struct {
+    Node *nodes;
+    int capacity;
+    _Alignas(CACHE_LINE) atomic_int used; // Bump allocator over nodes
+} Tree;
+
+typedef struct {
+    _Alignas(CACHE_LINE) SnakeMcts *mcts;
+    Tree *tree;
+    SnakeGame *game;          // Scratch copy of the root for each simulation
+    SnakeRng rng;
+    long iterations;
+    int depth;
+    pthread_t thread;
+    int path[MAX_DEPTH + 1];
+} Worker;
+
+struct SnakeMcts {
+    SnakeMctsConfig config;   // With the defaults filled in
+    int width, height;
+    Tree *trees;
+    Worker *workers;
+
+    // The search in progress
+    const SnakeGame *root;
+    long long deadline;       // CLOCK_MONOTONIC nanoseconds, 0 for none
+    _Alignas(CACHE_LINE) atomic_long started;
+};
+
+static long long MonotonicNow() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// --- Expand a leaf: claim it, then take 4 nodes from the pool ---
+static unsigned Expand(Tree *t, Node *node) {
+    unsigned expected = CHILDREN_NONE;
+    if (!atomic_compare_exchange_strong_explicit(&node->children, &expected, CHILDREN_BUSY,
+                                                 memory_order_acq_rel, memory_order_acquire)) {
+        return expected; // Someone else got there first
+    }
+    int first = atomic_fetch_add_explicit(&t->used, 4, memory_order_relaxed);
+    if (first + 4 > t->capacity) {
+        atomic_store_explicit(&node->children, CHILDREN_FULL, memory_order_release);
+        return CHILDREN_FULL;
+    }
+    for (int k = 0; k < 4; k++) {
+        Node *c = &t->nodes[first + k];
+        atomic_init(&c->visits, 0);
+        atomic_init(&c->children, CHILDREN_NONE);
+        atomic_init(&c->value, 0);
+    }
+    atomic_store_explicit(&node->children, (unsigned)first, memory_order_release);
+    return (unsigned)first;
+}
+
+// --- UCT: the child with the best mean return plus exploration bonus ---
+// Unvisited children come first, in random order.
+static enum eDirection Select(Worker *w, const Node *node, unsigned children) {
+    const SnakeMctsConfig *c = &w->mcts->config;
+    const Node *nodes = w->tree->nodes;
+    enum eDirection reverse = SnakeOpposite(w->game->lastMove);
+    double logN = log((double)atomic_load_explicit(&node->visits, memory_order_relaxed) + 1.0);
+    enum eDirection best = STOP;
+    double bestScore = -INFINITY;
+
+    for (enum eDirection d = LEFT; d <= DOWN; d++) {
+        if (d == reverse) {
+            continue; // SnakeSteer() would ignore it
+        }
+        const Node *child = &nodes[children + d - LEFT];
+        unsigned n = atomic_load_explicit(&child->visits, memory_order_relaxed);
+        double score;
+        if (n == 0) {
+            score = 1e9 + SnakeRngBounded(&w->rng, 1024);
+        } else {
+            double q = (double)atomic_load_explicit(&child->value, memory_order_relaxed) / VALUE_SCALE / n;
+            score = q + c->exploration * sqrt(logN / n);
+        }
+        if (score > bestScore) {
+            bestScore = score;
+            best = d;
+        }
+    }
+    return best;
+}
+
+// --- Random move among those that do not hit the body at once, STOP if none ---
+static enum eDirection SafeMove(const SnakeGame *g, SnakeRng *rng) {
+    enum eDirection safe[4];
+    int n = 0;
+    int head = SnakeHeadCell(g);
+    int tail = g->nTail > 0 ? SnakeTailCell(g, g->nTail - 1) : -1; // Moves away this tick
+    for (enum eDirection d = LEFT; d <= DOWN; d++) {
+        int cell = SnakeNeighbor(g, head, d);
+        if (d != SnakeOpposite(g->lastMove) && (!SnakeCellOccupied(g, cell) || cell == tail)) {
+            safe[n++] = d;
+        }
+    }
+    return n > 0 ? safe[SnakeRngBounded(rng, (uint32_t)n)] : STOP;
+}
+
+// --- Rollout move ---
+static enum eDirection RolloutMove(Worker *w) {
+    return SafeMove(w->game, &w->rng);
+}
+
+// --- Reward for one step: +1 per food, -1 for dying, discounted per tick ---
+static double Reward(SnakeStepResult r, double discount) {
+    double reward = 0.0;
+    if (r.events & SNAKE_EVENT_ATE) reward += discount;
+    if (r.events & SNAKE_EVENT_DIED) reward -= discount;
+    return reward;
+}
+
+// --- One simulation: walk down the tree, expand, roll out, back up ---
+static void Simulate(Worker *w) {
+    SnakeMcts *m = w->mcts;
+    Tree *t = w->tree;
+    SnakeGame *g = w->game;
+    int vl = m->config.virtualLoss;
+
+    SnakeClone(g, m->root);
+    SnakeReseedFood(g, SnakeRngNext(&w->rng));
+
+    int depth = 0;
+    unsigned index = 0;
+    double ret = 0.0;
+    double discount = 1.0;
+    w->path[0] = 0;
+    atomic_fetch_add_explicit(&t->nodes[0].visits, 1, memory_order_relaxed);
+
+    while (!SnakeIsOver(g) && depth < MAX_DEPTH) {
+        Node *node = &t->nodes[index];
+        unsigned children = atomic_load_explicit(&node->children, memory_order_acquire);
+        if (children == CHILDREN_NONE) {
+            children = Expand(t, node);
+        }
+        if (children == CHILDREN_BUSY || children == CHILDREN_FULL) {
+            break;
+        }
+        enum eDirection d = Select(w, node, children);
+        index = children + d - LEFT;
+        Node *child = &t->nodes[index];
+        atomic_fetch_add_explicit(&child->visits, (unsigned)vl, memory_order_relaxed);
+        atomic_fetch_sub_explicit(&child->value, (long long)(vl * VALUE_SCALE), memory_order_relaxed);
+        w->path[++depth] = (int)index;
+
+        ret += Reward(SnakeStep(g, d), discount);
+        discount *= DISCOUNT;
+        if (atomic_load_explicit(&child->visits, memory_order_relaxed) == (unsigned)vl) {
+            break; // First visit: roll out from here
+        }
+    }
+
+    for (int k = 0; k < m->config.rolloutDepth && !SnakeIsOver(g); k++) {
+        ret += Reward(SnakeStep(g, RolloutMove(w)), discount);
+        discount *= DISCOUNT;
+    }
+
+    long long value = (long long)(ret * VALUE_SCALE);
+    atomic_fetch_add_explicit(&t->nodes[0].value, value, memory_order_relaxed);
+    for (int i = 1; i <= depth; i++) {
+        Node *node = &t->nodes[w->path[i]];
+        atomic_fetch_sub_explicit(&node->visits, (unsigned)(vl - 1), memory_order_relaxed);
+        atomic_fetch_add_explicit(&node->value, value + (long long)(vl * VALUE_SCALE), memory_order_relaxed);
+    }
+    if (depth > w->depth) {
+        w->depth = depth;
+    }
+    w->iterations++;
+}
+
+static void *WorkerMain(void *arg) {
+    Worker *w = arg;
+    SnakeMcts *m = w->mcts;
+    for (;;) {
+        if (m->config.iterations > 0 &&
+            atomic_fetch_add_explicit(&m->started, 1, memory_order_relaxed) >= m->config.iterations) {
+            break;
+        }
+        if (m->deadline != 0 && w->iterations % CHECK_CLOCK_EVERY == 0 && MonotonicNow() >= m->deadline) {
+            break;
+        }
+        Simulate(w);
+    }
+    return NULL;
+}
+
+SnakeMcts *SnakeMctsCreate(const SnakeMctsConfig *config, int width, int height) {
+    if (config->iterations <= 0 && config->timeBudgetUs <= 0) {
+        return NULL; // The search would never end
+    }
+    if (config->nodes > 0 && config->nodes < MIN_NODES) {
+        return NULL; // The root could never be expanded
+    }
+    SnakeMcts *m = aligned_alloc(CACHE_LINE, sizeof(SnakeMcts));
+    if (m == NULL) {
+        return NULL;
+    }
+    memset(m, 0, sizeof(*m));
+    m->config = *config;
+    SnakeMctsConfig *c = &m->config;
+    if (c->threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        c->threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (c->trees <= 0) c->trees = 1;
+    if (c->trees > c->threads) c->trees = c->threads;
+    if (c->nodes <= 0) c->nodes = DEFAULT_NODES;
+    if (c->rolloutDepth <= 0) c->rolloutDepth = DEFAULT_ROLLOUT_DEPTH;
+    if (c->exploration <= 0) c->exploration = DEFAULT_EXPLORATION;
+    if (c->virtualLoss <= 0) c->virtualLoss = DEFAULT_VIRTUAL_LOSS;
+    m->width = width;
+    m->height = height;
+
+    m->trees = aligned_alloc(CACHE_LINE, sizeof(Tree) * (size_t)c->trees);
+    m->workers = aligned_alloc(CACHE_LINE, sizeof(Worker) * (size_t)c->threads);
+    if (m->trees == NULL || m->workers == NULL) {
+        free(m->trees);
+        free(m->workers);
+        free(m);
+        return NULL;
+    }
+    memset(m->trees, 0, sizeof(Tree) * (size_t)c->trees);
+    memset(m->workers, 0, sizeof(Worker) * (size_t)c->threads);
+
+    bool ok = true;
+    for (int k = 0; k < c->trees; k++) {
+        m->trees[k].capacity = c->nodes;
+        m->trees[k].nodes = malloc(sizeof(Node) * (size_t)c->nodes);
+        ok = ok && m->trees[k].nodes != NULL;
+    }
+    for (int k = 0; k < c->threads; k++) {
+        Worker *w = &m->workers[k];
+        w->mcts = m;
+        w->tree = &m->trees[k % c->trees];
+        w->game = SnakeCreate(width, height);
+        ok = ok && w->game != NULL;
+    }
+    if (!ok) {
+        SnakeMctsDestroy(m);
+        return NULL;
+    }
+    return m;
+}
+
+void SnakeMctsDestroy(SnakeMcts *m) {
+    if (m == NULL) {
+        return;
+    }
+    for (int k = 0; k < m->config.trees; k++) {
+        free(m->trees[k].nodes);
+    }
+    for (int k = 0; k < m->config.threads; k++) {
+        SnakeDestroy(m->workers[k].game);
+    }
+    free(m->trees);
+    free(m->workers);
+    free(m);
+}
+
+enum eDirection SnakeMctsMove(SnakeMcts *m, const SnakeGame *game, SnakeMctsStats *stats) {
+    const SnakeMctsConfig *c = &m->config;
+    if (SnakeIsOver(game) || game->width != m->width || game->height != m->height) {
+        return STOP;
+    }
+    long long start = MonotonicNow();
+    m->root = game;
+    m->deadline = c->timeBudgetUs > 0 ? start + c->timeBudgetUs * 1000LL : 0;
+    atomic_store_explicit(&m->started, 0, memory_order_relaxed);
+    for (int k = 0; k < c->trees; k++) {
+        Tree *t = &m->trees[k];
+        atomic_store_explicit(&t->used, 1, memory_order_relaxed);
+        atomic_init(&t->nodes[0].visits, 0);
+        atomic_init(&t->nodes[0].children, CHILDREN_NONE);
+        atomic_init(&t->nodes[0].value, 0);
+    }
+    // Seeded from the position, so a single-threaded search with an
+    // iteration budget always picks the same move
+    for (int k = 0; k < c->threads; k++) {
+        Worker *w = &m->workers[k];
+        SnakeRngSeed(&w->rng, c->seed ^ (game->seed * 0x9e3779b97f4a7c15ULL) ^
+                              ((uint64_t)game->ticks << 20) ^ (uint64_t)k);
+        w->iterations = 0;
+        w->depth = 0;
+    }
+
+    // The caller's thread is worker 0
+    int started = 1;
+    for (; started < c->threads; started++) {
+        if (pthread_create(&m->workers[started].thread, NULL, WorkerMain, &m->workers[started]) != 0) {
+            break; // Search with the threads we have
+        }
+    }
+    WorkerMain(&m->workers[0]);
+    for (int k = 1; k < started; k++) {
+        pthread_join(m->workers[k].thread, NULL);
+    }
+
+    // Sum the root children of every tree; play the most visited
+    long visits[4] = { 0 };
+    double value[4] = { 0 };
+    for (int k = 0; k < c->trees; k++) {
+        const Tree *t = &m->trees[k];
+        unsigned children = atomic_load_explicit(&t->nodes[0].children, memory_order_acquire);
+        if (children == CHILDREN_NONE || children == CHILDREN_BUSY || children == CHILDREN_FULL) {
+            continue;
+        }
+        for (int d = 0; d < 4; d++) {
+            visits[d] += atomic_load_explicit(&t->nodes[children + d].visits, memory_order_relaxed);
+            value[d] += atomic_load_explicit(&t->nodes[children + d].value, memory_order_relaxed) / VALUE_SCALE;
+        }
+    }
+    enum eDirection best = STOP;
+    for (enum eDirection d = LEFT; d <= DOWN; d++) {
+        if (d == SnakeOpposite(game->lastMove) || visits[d - LEFT] == 0) {
+            continue;
+        }
+        if (best == STOP || visits[d - LEFT] > visits[best - LEFT] ||
+            (visits[d - LEFT] == visits[best - LEFT] &&
+             value[d - LEFT] / visits[d - LEFT] > value[best - LEFT] / visits[best - LEFT])) {
+            best = d;
+        }
+    }
+    if (best == STOP) {
+        // No simulation got past the root before the deadline: play a safe
+        // move rather than none
+        best = SafeMove(game, &m->workers[0].rng);
+        if (best == STOP) {
+            best = game->lastMove == RIGHT ? LEFT : RIGHT; // Every move dies; any will do
+        }
+    }
+
+    if (stats != NULL) {
+        memset(stats, 0, sizeof(*stats));
+        for (int k = 0; k < c->threads; k++) {
+            stats->iterations += m->workers[k].iterations;
+            if (m->workers[k].depth > stats->depth) {
+                stats->depth = m->workers[k].depth;
+            }
+        }
+        for (int k = 0; k < c->trees; k++) {
+            stats->nodes += atomic_load_explicit(&m->trees[k].used, memory_order_relaxed);
+        }
+        stats->elapsedUs = (long)((MonotonicNow() - start) / 1000);
+    }
+    return best;
+}
@@ -0,0 +1,50 @@
+#ifndef SNAKE_MCTS_H
+#define SNAKE_MCTS_H
+
+#include <stdint.h>
+
+#include "engine.h"
+
+// --- Monte Carlo Tree Search Agent ---
+// Picks moves by UCT search over the headless engine. Threads share each
+// tree (tree parallelism): visit counts and values are atomics, and a
+// thread walking down adds a virtual loss to every node on its path so the
+// others spread out instead of piling onto the same line. Several
+// independent trees (root parallelism) can run side by side; their root
+// visit counts are summed to choose the move. Nodes come from a pool
+// allocated once, so a search never calls malloc.
+//
+// Food is re-drawn in every simulation, so the search plans against
+// random food rather than the game's own RNG.
+
+typedef struct {
+    int threads;              // Search threads, 0 for one per online CPU
+    int trees;                // Independent trees, threads are dealt out round-robin
+    long iterations;          // Simulations per move, 0 for no limit
+    long timeBudgetUs;        // Microseconds per move, 0 for no limit (one limit is required)
+    int nodes;                // Pool size per tree, 0 for a default, else at least 5
+    int rolloutDepth;         // Random moves played past the tree, 0 for a default
+    double exploration;       // UCT constant, 0 for a default
+    int virtualLoss;          // Losses added per thread on a path, 0 for a default
+    uint64_t seed;            // Seeds the threads' rollout and food RNGs
+} SnakeMctsConfig;
+
+typedef struct {
+    long iterations;          // Simulations run for the last move
+    int nodes;                // Nodes used, summed over trees
+    int depth;                // Deepest path walked
+    long elapsedUs;
+} SnakeMctsStats;
+
+typedef struct SnakeMcts SnakeMcts;
+
+// --- Lifetime: one agent per board size, reused for every move ---
+// NULL if out of memory or the config sets neither limit or too few nodes.
+SnakeMcts *SnakeMctsCreate(const SnakeMctsConfig *config, int width, int height);
+void SnakeMctsDestroy(SnakeMcts *mcts);
+
+// --- Search from a game's current state and return the move to play ---
+// Returns STOP only when the game is over. stats may be NULL.
+enum eDirection SnakeMctsMove(SnakeMcts *mcts, const SnakeGame *game, SnakeMctsStats *stats);
+
+#endif
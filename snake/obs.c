@@ -0,0 +1,281 @@
+#include "obs.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// --- Sizes ---
+static size_t ElementSize(SnakeObsType type) {
+    return type == SNAKE_OBS_U8 ? sizeof(uint8_t) : sizeof(float);
+}
+
+size_t SnakeObsPlanesSize(const SnakeBatch *b, SnakeObsType type) {
+    return (size_t)b->count * SNAKE_OBS_PLANES * b->cells * ElementSize(type);
+}
+
+size_t SnakeObsCropsSize(const SnakeBatch *b, SnakeObsType type, int cropRadius) {
+    size_t side = 2 * (size_t)cropRadius + 1;
+    return (size_t)b->count * SNAKE_OBS_PLANES * side * side * ElementSize(type);
+}
+
+size_t SnakeObsRaysSize(const SnakeBatch *b) {
+    return (size_t)b->count * SNAKE_OBS_RAYS * sizeof(float);
+}
+
+// --- Store one value of a plane-shaped buffer in the observation's type ---
+static void Store(const SnakeObs *o, void *buf, size_t index, float value) {
+    if (o->type == SNAKE_OBS_U8) {
+        ((uint8_t *)buf)[index] = (uint8_t)value;
+    } else {
+        ((float *)buf)[index] = value;
+    }
+}
+
+static size_t PlaneIndex(const SnakeObs *o, int lane, int plane, int cell) {
+    return ((size_t)lane * SNAKE_OBS_PLANES + plane) * o->cells + cell;
+}
+
+static void SetPlane(SnakeObs *o, int lane, int plane, int cell, float value) {
+    Store(o, o->planes, PlaneIndex(o, lane, plane, cell), value);
+}
+
+// --- Column-major occupancy, so vertical rays scan contiguous bytes ---
+static unsigned char *Column(const SnakeObs *o, int lane, int x) {
+    return o->columns + (size_t)lane * o->cells + (size_t)x * o->height;
+}
+
+static void SetColumn(SnakeObs *o, int lane, int cell, unsigned char value) {
+    Column(o, lane, cell % o->width)[cell / o->width] = value;
+}
+
+// --- Index of the first / last nonzero byte in p[0, n), or -1 ---
+static int FirstSet(const unsigned char *p, int n) {
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        int set = _mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)) ^ 0xffff;
+        if (set != 0) {
+            return i + __builtin_ctz((unsigned)set);
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        if (p[i]) return i;
+    }
+    return -1;
+}
+
+static int LastSet(const unsigned char *p, int n) {
+    int i = n;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    for (; i >= 16; i -= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i - 16));
+        int set = _mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)) ^ 0xffff;
+        if (set != 0) {
+            return i - 16 + 31 - __builtin_clz((unsigned)set);
+        }
+    }
+#endif
+    for (; i > 0; i--) {
+        if (p[i - 1]) return i - 1;
+    }
+    return -1;
+}
+
+// --- Cells from position pos to the nearest set byte of a wrapped line ---
+// The head's own cell is set, so a clear line always ends at size.
+static int DistanceForward(const unsigned char *line, int size, int pos) {
+    int k = FirstSet(line + pos + 1, size - pos - 1);
+    if (k >= 0) {
+        return k + 1;
+    }
+    return size - pos + FirstSet(line, pos + 1);
+}
+
+static int DistanceBackward(const unsigned char *line, int size, int pos) {
+    int k = LastSet(line, pos);
+    if (k >= 0) {
+        return pos - k;
+    }
+    return size - LastSet(line + pos, size - pos);
+}
+
+// --- Ray features for one lane ---
+static void WriteRays(SnakeObs *o, const SnakeBatch *b, int lane) {
+    int w = o->width;
+    int h = o->height;
+    int x = b->headX[lane];
+    int y = b->headY[lane];
+    int fx = b->foodX[lane];
+    int fy = b->foodY[lane];
+    const unsigned char *row = b->occupied + (size_t)lane * o->cells + (size_t)y * w;
+    const unsigned char *column = Column(o, lane, x);
+    float *r = o->rays + (size_t)lane * SNAKE_OBS_RAYS;
+
+    r[0] = (float)DistanceBackward(row, w, x);
+    r[1] = fy == y && fx >= 0 && fx != x ? (float)((x - fx + w) % w) : 0.0f;
+    r[2] = (float)DistanceForward(row, w, x);
+    r[3] = fy == y && fx >= 0 && fx != x ? (float)((fx - x + w) % w) : 0.0f;
+    r[4] = (float)DistanceBackward(column, h, y);
+    r[5] = fx == x && fy >= 0 && fy != y ? (float)((y - fy + h) % h) : 0.0f;
+    r[6] = (float)DistanceForward(column, h, y);
+    r[7] = fx == x && fy >= 0 && fy != y ? (float)((fy - y + h) % h) : 0.0f;
+}
+
+// --- Egocentric crop: every plane in a square window centred on the head ---
+static void WriteCrop(SnakeObs *o, const SnakeBatch *b, int lane) {
+    int w = o->width;
+    int h = o->height;
+    int radius = o->cropRadius;
+    int side = 2 * radius + 1;
+    size_t elem = ElementSize(o->type);
+    const char *planes = o->planes;
+    char *crops = o->crops;
+
+    for (int p = 0; p < SNAKE_OBS_PLANES; p++) {
+        const char *src = planes + PlaneIndex(o, lane, p, 0) * elem;
+        char *dst = crops + ((size_t)lane * SNAKE_OBS_PLANES + p) * side * side * elem;
+        for (int dy = -radius; dy <= radius; dy++) {
+            int sy = ((b->headY[lane] + dy) % h + h) % h;
+            for (int dx = -radius; dx <= radius; dx++) {
+                int sx = ((b->headX[lane] + dx) % w + w) % w;
+                memcpy(dst, src + ((size_t)sy * w + sx) * elem, elem);
+                dst += elem;
+            }
+        }
+    }
+}
+
+// --- Body ages, walking the ring from the neck to the tail ---
+static void WriteAges(SnakeObs *o, const SnakeBatch *b, int lane) {
+    const int *tail = b->tail + (size_t)lane * o->cells;
+    int length = b->nTail[lane] + 1;
+    for (int i = 0; i < b->nTail[lane]; i++) {
+        int cell = tail[(b->tailStart[lane] + i) % o->cells];
+        int age = i + 1;
+        float value = o->type == SNAKE_OBS_U8 ? (float)(age < 255 ? age : 255)
+                                              : (float)age / (float)length;
+        SetPlane(o, lane, SNAKE_OBS_AGE, cell, value);
+    }
+}
+
+static void WriteDerived(SnakeObs *o, const SnakeBatch *b, int lane) {
+    if (o->crops != NULL) {
+        WriteCrop(o, b, lane);
+    }
+    if (o->rays != NULL) {
+        WriteRays(o, b, lane);
+    }
+}
+
+// --- Full rewrite of one lane ---
+static void WriteLane(SnakeObs *o, const SnakeBatch *b, int lane) {
+    size_t elem = ElementSize(o->type);
+    memset((char *)o->planes + PlaneIndex(o, lane, 0, 0) * elem, 0,
+           (size_t)SNAKE_OBS_PLANES * o->cells * elem);
+
+    const unsigned char *occupied = b->occupied + (size_t)lane * o->cells;
+    for (int cell = 0; cell < o->cells; cell++) {
+        SetColumn(o, lane, cell, occupied[cell]);
+    }
+
+    const int *tail = b->tail + (size_t)lane * o->cells;
+    for (int i = 0; i < b->nTail[lane]; i++) {
+        SetPlane(o, lane, SNAKE_OBS_BODY, tail[(b->tailStart[lane] + i) % o->cells], 1.0f);
+    }
+    WriteAges(o, b, lane);
+    SetPlane(o, lane, SNAKE_OBS_HEAD, b->headY[lane] * o->width + b->headX[lane], 1.0f);
+    if (b->foodX[lane] >= 0) {
+        SetPlane(o, lane, SNAKE_OBS_FOOD, b->foodY[lane] * o->width + b->foodX[lane], 1.0f);
+    }
+    WriteDerived(o, b, lane);
+}
+
+// --- Apply one lane's step delta ---
+static void UpdateLane(SnakeObs *o, const SnakeBatch *b, int lane) {
+    int prev = b->prevHead[lane];
+    if (prev < 0) {
+        return; // The snake did not move
+    }
+    int head = b->headY[lane] * o->width + b->headX[lane];
+    int vacated = b->vacated[lane];
+
+    if (vacated >= 0) {
+        SetPlane(o, lane, SNAKE_OBS_BODY, vacated, 0.0f);
+        SetPlane(o, lane, SNAKE_OBS_AGE, vacated, 0.0f);
+        SetColumn(o, lane, vacated, 0);
+    }
+    SetPlane(o, lane, SNAKE_OBS_HEAD, prev, 0.0f);
+    if (b->nTail[lane] > 0) {
+        SetPlane(o, lane, SNAKE_OBS_BODY, prev, 1.0f); // The old head is now the neck
+    }
+    SetPlane(o, lane, SNAKE_OBS_HEAD, head, 1.0f);
+    SetColumn(o, lane, head, 1);
+    if (b->placedFood[lane] >= 0) {
+        SetPlane(o, lane, SNAKE_OBS_FOOD, head, 0.0f); // Eaten
+        SetPlane(o, lane, SNAKE_OBS_FOOD, b->placedFood[lane], 1.0f);
+    }
+    WriteAges(o, b, lane);
+    WriteDerived(o, b, lane);
+}
+
+static bool Aligned(const void *p) {
+    return ((uintptr_t)p & (SNAKE_OBS_ALIGN - 1)) == 0;
+}
+
+SnakeObs *SnakeObsCreate(const SnakeBatch *b, SnakeObsType type, void *planes,
+                         void *crops, int cropRadius, float *rays) {
+    if (planes == NULL || !Aligned(planes) || (crops != NULL && !Aligned(crops)) ||
+        (rays != NULL && !Aligned(rays)) || (crops != NULL && cropRadius < 1)) {
+        return NULL;
+    }
+    SnakeObs *o = malloc(sizeof(SnakeObs));
+    if (o == NULL) {
+        return NULL;
+    }
+    o->columns = malloc((size_t)b->count * b->cells);
+    if (o->columns == NULL) {
+        free(o);
+        return NULL;
+    }
+    o->count = b->count;
+    o->width = b->width;
+    o->height = b->height;
+    o->cells = b->cells;
+    o->type = type;
+    o->cropRadius = crops != NULL ? cropRadius : 0;
+    o->planes = planes;
+    o->crops = crops;
+    o->rays = rays;
+    SnakeObsWriteAll(o, b);
+    return o;
+}
+
+void SnakeObsDestroy(SnakeObs *obs) {
+    if (obs != NULL) {
+        free(obs->columns);
+        free(obs);
+    }
+}
+
+void SnakeObsWriteAll(SnakeObs *o, const SnakeBatch *b) {
+    for (int lane = 0; lane < o->count; lane++) {
+        WriteLane(o, b, lane);
+    }
+}
+
+void SnakeObsUpdate(SnakeObs *o, const SnakeBatch *b, const uint8_t *dones) {
+    for (int lane = 0; lane < o->count; lane++) {
+        if (dones[lane]) {
+            WriteLane(o, b, lane); // Reset to a new game
+        } else {
+            UpdateLane(o, b, lane);
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef SNAKE_OBS_H
+#define SNAKE_OBS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "batch.h"
+
+// --- Observation Tensors ---
+// Writes neural-net inputs for every lane of a SnakeBatch straight into
+// caller-owned buffers, so nothing has to re-rasterize the board. After the
+// first full write, SnakeObsUpdate() applies only what each step changed:
+// the cells the head entered and left, the vacated tail cell and the food.
+// The age plane changes on every body cell each tick, so it is rewritten by
+// walking the body ring (O(length), never a board scan). Crops follow the
+// head and are re-copied from the planes; lanes that were reset are
+// rewritten in full.
+
+// --- Planes, in channel order ---
+#define SNAKE_OBS_HEAD   0 // 1 on the head
+#define SNAKE_OBS_BODY   1 // 1 on each body segment behind the head
+#define SNAKE_OBS_AGE    2 // Ticks since a body cell was entered (u8: saturates at 255;
+                           // f32: divided by the snake length)
+#define SNAKE_OBS_FOOD   3 // 1 on the food
+#define SNAKE_OBS_PLANES 4
+
+// --- Rays from the head, per direction LEFT, RIGHT, UP, DOWN ---
+// Two floats each: cells to the nearest snake cell (the board wraps, so a
+// clear line reaches the head again at width or height), and cells to the
+// food if it lies on that line, else 0.
+#define SNAKE_OBS_RAYS 8
+
+#define SNAKE_OBS_ALIGN 64 // Required alignment of every caller buffer
+
+typedef enum { SNAKE_OBS_U8, SNAKE_OBS_F32 } SnakeObsType;
+
+typedef struct SnakeObs {
+    int count, width, height, cells;
+    SnakeObsType type;
+    int cropRadius;          // Crops are (2 * cropRadius + 1) cells square
+    void *planes;            // [count][SNAKE_OBS_PLANES][height][width]
+    void *crops;             // [count][SNAKE_OBS_PLANES][side][side], or NULL
+    float *rays;             // [count][SNAKE_OBS_RAYS], or NULL
+    unsigned char *columns;  // Column-major copy of each lane's occupancy, for vertical rays
+} SnakeObs;
+
+// --- Bytes each caller buffer needs ---
+size_t SnakeObsPlanesSize(const SnakeBatch *batch, SnakeObsType type);
+size_t SnakeObsCropsSize(const SnakeBatch *batch, SnakeObsType type, int cropRadius);
+size_t SnakeObsRaysSize(const SnakeBatch *batch);
+
+// --- Bind buffers to a batch and write every lane in full ---
+// planes is required; crops (with cropRadius > 0) and rays may be NULL.
+// Returns NULL if a buffer is misaligned or memory runs out.
+SnakeObs *SnakeObsCreate(const SnakeBatch *batch, SnakeObsType type, void *planes,
+                         void *crops, int cropRadius, float *rays);
+void SnakeObsDestroy(SnakeObs *obs);
+
+// --- Rewrite everything from the batch state ---
+void SnakeObsWriteAll(SnakeObs *obs, const SnakeBatch *batch);
+
+// --- Bring the buffers up to date after SnakeBatchStep() ---
+// dones is the array that step filled in.
+void SnakeObsUpdate(SnakeObs *obs, const SnakeBatch *batch, const uint8_t *dones);
+
+#endif
@@ -0,0 +1,530 @@
+#include "replay.h"
+#include "state.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define REPLAY_MAGIC "SNKR"
+#define INDEX_MAGIC "SNKI"
+#define BUFFER_SIZE 4096
+#define END_RECORD 0          // Move records carry 1..4 (LEFT..DOWN) in their low bits
+#define KEYFRAME_RECORD 5
+
+// --- Recorder ---
+struct SnakeRecorder {
+    int fd;
+    bool failed;              // A write failed; later output is dropped
+    unsigned long lastTick;   // Tick of the last record written
+    enum eDirection lastDir;
+    unsigned long keyframeTicks;
+    unsigned long lastKeyframe; // Tick of the last keyframe, or of the reset
+    uint64_t written;         // Bytes of the file so far, buffered or not
+    uint64_t recordsStart;    // Offset of the current game's first record
+    SnakeReplayKeyframe *index; // The current game's keyframes
+    int nIndex, indexCapacity;
+    uint8_t *snapshot;        // Scratch for keyframe images
+    size_t snapshotCapacity;
+    size_t n;
+    uint8_t buf[BUFFER_SIZE];
+};
+
+static void WriteOut(SnakeRecorder *rec, const uint8_t *p, size_t len) {
+    while (len > 0 && !rec->failed) {
+        ssize_t n = write(rec->fd, p, len);
+        if (n < 0) {
+            rec->failed = true;
+            break;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+}
+
+static void Flush(SnakeRecorder *rec) {
+    WriteOut(rec, rec->buf, rec->n);
+    rec->n = 0;
+}
+
+static void PutBytes(SnakeRecorder *rec, const void *data, size_t len) {
+    rec->written += len;
+    if (rec->n + len > BUFFER_SIZE) {
+        Flush(rec);
+        if (len > BUFFER_SIZE) {
+            WriteOut(rec, data, len); // A keyframe of a huge board
+            return;
+        }
+    }
+    memcpy(rec->buf + rec->n, data, len);
+    rec->n += len;
+}
+
+static void PutVarint(SnakeRecorder *rec, uint64_t v) {
+    uint8_t bytes[10];
+    size_t n = 0;
+    do {
+        bytes[n] = (uint8_t)(v & 0x7f);
+        v >>= 7;
+        bytes[n++] |= v != 0 ? 0x80 : 0;
+    } while (v != 0);
+    PutBytes(rec, bytes, n);
+}
+
+static void PutU64(SnakeRecorder *rec, uint64_t v) {
+    uint8_t bytes[8];
+    for (int i = 0; i < 8; i++) {
+        bytes[i] = (uint8_t)(v >> (8 * i));
+    }
+    PutBytes(rec, bytes, 8);
+}
+
+SnakeRecorder *SnakeRecorderOpen(const char *path, unsigned long keyframeTicks) {
+    SnakeRecorder *rec = calloc(1, sizeof(SnakeRecorder));
+    if (rec == NULL) {
+        return NULL;
+    }
+    rec->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (rec->fd < 0) {
+        free(rec);
+        return NULL;
+    }
+    rec->keyframeTicks = keyframeTicks;
+    rec->lastDir = STOP;
+    return rec;
+}
+
+int SnakeRecorderClose(SnakeRecorder *rec) {
+    if (rec == NULL) {
+        return 0;
+    }
+    Flush(rec);
+    bool failed = close(rec->fd) != 0 || rec->failed;
+    free(rec->index);
+    free(rec->snapshot);
+    free(rec);
+    return failed ? -1 : 0;
+}
+
+void SnakeRecorderBegin(SnakeRecorder *rec, const SnakeGame *g) {
+    uint8_t version = SNAKE_REPLAY_VERSION;
+    PutBytes(rec, REPLAY_MAGIC, 4);
+    PutBytes(rec, &version, 1);
+    PutVarint(rec, (uint64_t)g->width);
+    PutVarint(rec, (uint64_t)g->height);
+    PutU64(rec, g->seed);
+    rec->lastTick = g->ticks;
+    rec->lastDir = STOP;
+    rec->lastKeyframe = g->ticks;
+    rec->recordsStart = rec->written;
+    rec->nIndex = 0;
+}
+
+// --- Keyframe record: the whole game, indexed for the footer ---
+static void PutKeyframe(SnakeRecorder *rec, const SnakeGame *g) {
+    size_t size = SnakeSnapshotSize(g);
+    if (size > rec->snapshotCapacity) {
+        uint8_t *snapshot = realloc(rec->snapshot, size);
+        if (snapshot == NULL) {
+            return; // Seeking falls back to an earlier keyframe
+        }
+        rec->snapshot = snapshot;
+        rec->snapshotCapacity = size;
+    }
+    if (rec->nIndex == rec->indexCapacity) {
+        int capacity = rec->indexCapacity ? 2 * rec->indexCapacity : 64;
+        SnakeReplayKeyframe *index = realloc(rec->index, (size_t)capacity * sizeof(SnakeReplayKeyframe));
+        if (index == NULL) {
+            return;
+        }
+        rec->index = index;
+        rec->indexCapacity = capacity;
+    }
+    rec->index[rec->nIndex++] = (SnakeReplayKeyframe){ g->ticks, (size_t)(rec->written - rec->recordsStart) };
+    SnakeSnapshotWrite(g, rec->snapshot);
+    PutVarint(rec, (uint64_t)(g->ticks - rec->lastTick) << 3 | KEYFRAME_RECORD);
+    PutVarint(rec, size);
+    PutBytes(rec, rec->snapshot, size);
+    rec->lastTick = g->ticks;
+    rec->lastKeyframe = g->ticks;
+}
+
+// --- Move record, if the direction changed since the last one ---
+static void PutMove(SnakeRecorder *rec, const SnakeGame *g) {
+    if (g->dir != rec->lastDir) {
+        PutVarint(rec, (uint64_t)(g->ticks - rec->lastTick) << 3 | (uint64_t)g->dir);
+        rec->lastTick = g->ticks;
+        rec->lastDir = g->dir;
+    }
+}
+
+void SnakeRecorderTick(SnakeRecorder *rec, const SnakeGame *g) {
+    PutMove(rec, g);
+    if (rec->keyframeTicks != 0 && g->ticks - rec->lastKeyframe >= rec->keyframeTicks) {
+        PutKeyframe(rec, g);
+    }
+}
+
+void SnakeRecorderEnd(SnakeRecorder *rec, const SnakeGame *g) {
+    // A steer since the last tick, say right before quitting, is already in
+    // the final hash, so the replay must make it too
+    PutMove(rec, g);
+    PutVarint(rec, (uint64_t)(g->ticks - rec->lastTick) << 3 | END_RECORD);
+    PutVarint(rec, (uint64_t)g->score);
+    PutU64(rec, g->hash);
+
+    uint64_t indexStart = rec->written;
+    PutVarint(rec, (uint64_t)rec->nIndex);
+    unsigned long tick = 0;
+    size_t offset = 0;
+    for (int i = 0; i < rec->nIndex; i++) {
+        PutVarint(rec, rec->index[i].tick - tick);
+        PutVarint(rec, rec->index[i].offset - offset);
+        tick = rec->index[i].tick;
+        offset = rec->index[i].offset;
+    }
+    uint8_t size[4];
+    uint32_t indexSize = (uint32_t)(rec->written - indexStart);
+    for (int i = 0; i < 4; i++) {
+        size[i] = (uint8_t)(indexSize >> (8 * i));
+    }
+    PutBytes(rec, size, 4);
+    PutBytes(rec, INDEX_MAGIC, 4);
+    Flush(rec); // A finished game is on disk even if the process dies later
+}
+
+// --- Reader ---
+// Both return false instead of reading past end.
+static bool GetVarint(const uint8_t **p, const uint8_t *end, uint64_t *v) {
+    *v = 0;
+    for (int shift = 0; *p < end && shift < 64; shift += 7) {
+        uint8_t b = *(*p)++;
+        *v |= (uint64_t)(b & 0x7f) << shift;
+        if ((b & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool GetU64(const uint8_t **p, const uint8_t *end, uint64_t *v) {
+    if (end - *p < 8) {
+        return false;
+    }
+    *v = 0;
+    for (int i = 0; i < 8; i++) {
+        *v |= (uint64_t)(*p)[i] << (8 * i);
+    }
+    *p += 8;
+    return true;
+}
+
+// --- Keyframes found while parsing, for every game of a file ---
+typedef struct {
+    SnakeReplayKeyframe *items;
+    int count, capacity;
+} KeyframeList;
+
+static bool AddKeyframe(KeyframeList *list, unsigned long tick, size_t offset) {
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? 2 * list->capacity : 64;
+        SnakeReplayKeyframe *items = realloc(list->items, (size_t)capacity * sizeof(SnakeReplayKeyframe));
+        if (items == NULL) {
+            return false;
+        }
+        list->items = items;
+        list->capacity = capacity;
+    }
+    list->items[list->count++] = (SnakeReplayKeyframe){ tick, offset };
+    return true;
+}
+
+// --- Check a game's index footer against the keyframes its records hold ---
+static bool ParseIndex(const uint8_t **p, const uint8_t *end, const SnakeReplayKeyframe *found, int nFound) {
+    const uint8_t *start = *p;
+    uint64_t count, tick = 0, offset = 0, size;
+    if (!GetVarint(p, end, &count) || count != (uint64_t)nFound) {
+        return false;
+    }
+    for (int i = 0; i < nFound; i++) {
+        uint64_t dt, doff;
+        if (!GetVarint(p, end, &dt) || !GetVarint(p, end, &doff)) {
+            return false;
+        }
+        tick += dt;
+        offset += doff;
+        if (tick != found[i].tick || offset != found[i].offset) {
+            return false;
+        }
+    }
+    size_t indexSize = (size_t)(*p - start);
+    if (end - *p < 8) {
+        return false;
+    }
+    size = (uint64_t)(*p)[0] | (uint64_t)(*p)[1] << 8 | (uint64_t)(*p)[2] << 16 | (uint64_t)(*p)[3] << 24;
+    if (size != indexSize || memcmp(*p + 4, INDEX_MAGIC, 4) != 0) {
+        return false;
+    }
+    *p += 8;
+    return true;
+}
+
+// --- Parse one game starting at *p; false if it is malformed ---
+static bool ParseGame(const uint8_t **p, const uint8_t *end, SnakeReplay *r, KeyframeList *keyframes) {
+    uint64_t width, height;
+    if (end - *p < 5 || memcmp(*p, REPLAY_MAGIC, 4) != 0 || (*p)[4] < 1 || (*p)[4] > SNAKE_REPLAY_VERSION) {
+        return false;
+    }
+    int version = (*p)[4];
+    *p += 5;
+    if (!GetVarint(p, end, &width) || !GetVarint(p, end, &height) || !GetU64(p, end, &r->seed) ||
+        width < 1 || height < 1 || width > INT_MAX / height) {
+        return false;
+    }
+    r->width = (int)width;
+    r->height = (int)height;
+    r->moves = *p;
+    r->complete = false;
+    int firstKeyframe = keyframes->count;
+    r->nKeyframes = 0;
+
+    uint64_t ticks = 0;
+    uint64_t recorded = 0;    // Tick of the last whole record
+    while (*p < end) {
+        const uint8_t *record = *p;
+        uint64_t v, score, hash, size;
+        if (!GetVarint(p, end, &v)) {
+            break; // Cut off mid-record: keep what came before
+        }
+        ticks = recorded + (v >> 3);
+        int kind = (int)(v & 7);
+        if (kind == END_RECORD) {
+            if (!GetVarint(p, end, &score) || !GetU64(p, end, &hash)) {
+                *p = record;
+                break;
+            }
+            r->movesSize = (size_t)(record - r->moves);
+            r->complete = true;
+            r->ticks = (unsigned long)ticks;
+            r->score = (int)score;
+            r->hash = hash;
+            r->nKeyframes = keyframes->count - firstKeyframe;
+            return version < 2 || ParseIndex(p, end, keyframes->items + firstKeyframe, r->nKeyframes);
+        }
+        if (kind == KEYFRAME_RECORD && version >= 2) {
+            if (!GetVarint(p, end, &size) || size > (uint64_t)(end - *p)) {
+                *p = record;
+                break;
+            }
+            *p += size;
+            if (!AddKeyframe(keyframes, (unsigned long)ticks, (size_t)(record - r->moves))) {
+                return false;
+            }
+        } else if (kind > DOWN) {
+            return false;
+        }
+        recorded = ticks;
+    }
+    // A game the recorder never finished, e.g. because it was killed. It
+    // plays up to its last record.
+    r->movesSize = (size_t)(*p - r->moves);
+    r->ticks = (unsigned long)recorded;
+    r->nKeyframes = keyframes->count - firstKeyframe;
+    *p = end;
+    return true;
+}
+
+// --- Split a file's bytes into games ---
+static SnakeReplayFile *Parse(SnakeReplayFile *f) {
+    // Each game is at least a 14-byte header, which bounds the count
+    f->games = malloc((f->size / 14 + 1) * sizeof(SnakeReplay));
+    bool ok = f->games != NULL;
+    KeyframeList keyframes = { NULL, 0, 0 };
+    const uint8_t *p = f->data;
+    const uint8_t *end = f->data + f->size;
+    while (ok && p < end) {
+        SnakeReplay *r = &f->games[f->count++];
+        r->data = p;
+        ok = ParseGame(&p, end, r, &keyframes);
+        r->dataSize = (size_t)(p - r->data);
+    }
+    f->keyframes = keyframes.items;
+    if (!ok) {
+        SnakeReplayClose(f);
+        return NULL;
+    }
+    // The list may have moved while it grew, so point into it only now
+    int at = 0;
+    for (int k = 0; k < f->count; k++) {
+        f->games[k].keyframes = f->keyframes + at;
+        at += f->games[k].nKeyframes;
+    }
+    return f;
+}
+
+SnakeReplayFile *SnakeReplayOpen(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    SnakeReplayFile *f = calloc(1, sizeof(SnakeReplayFile));
+    bool ok = f != NULL && fstat(fd, &st) == 0 && st.st_size > 0;
+    if (ok) {
+        f->size = (size_t)st.st_size;
+        f->owned = malloc(f->size);
+        f->data = f->owned;
+        ok = f->owned != NULL && read(fd, f->owned, f->size) == (ssize_t)f->size;
+    }
+    close(fd);
+    if (!ok) {
+        SnakeReplayClose(f);
+        return NULL;
+    }
+    return Parse(f);
+}
+
+SnakeReplayFile *SnakeReplayOpenMemory(const void *data, size_t size) {
+    SnakeReplayFile *f = size > 0 ? calloc(1, sizeof(SnakeReplayFile)) : NULL;
+    if (f == NULL) {
+        return NULL;
+    }
+    f->data = data;
+    f->size = size;
+    return Parse(f);
+}
+
+void SnakeReplayClose(SnakeReplayFile *f) {
+    if (f != NULL) {
+        free(f->keyframes);
+        free(f->games);
+        free(f->owned);
+        free(f);
+    }
+}
+
+// --- Playback ---
+// --- Advance to the next move record, stepping over keyframes ---
+static void NextMove(SnakeReplayCursor *c) {
+    const uint8_t *end = c->replay->moves + c->replay->movesSize;
+    for (;;) {
+        uint64_t v, size;
+        if (c->at >= end || !GetVarint(&c->at, end, &v)) {
+            c->nextTick = ULONG_MAX;
+            return;
+        }
+        c->nextTick += (unsigned long)(v >> 3);
+        c->nextDir = (enum eDirection)(v & 7);
+        if (c->nextDir != KEYFRAME_RECORD) {
+            return;
+        }
+        GetVarint(&c->at, end, &size); // Checked by SnakeReplayOpen()
+        c->at += size;
+    }
+}
+
+// --- Apply every move recorded for the game's current tick ---
+static void SteerDue(SnakeReplayCursor *c, SnakeGame *g) {
+    while (c->nextTick == g->ticks) {
+        SnakeSteer(g, c->nextDir);
+        NextMove(c);
+    }
+}
+
+void SnakeReplayStart(SnakeReplayCursor *c, const SnakeReplay *replay, SnakeGame *g) {
+    c->replay = replay;
+    c->at = replay->moves;
+    c->nextTick = 0;
+    c->lastMeal = 0;
+    c->stalled = false;
+    SnakeReset(g, replay->seed);
+    NextMove(c);
+    SteerDue(c, g);
+}
+
+bool SnakeReplayStep(SnakeReplayCursor *c, SnakeGame *g, SnakeStepResult *result) {
+    const SnakeReplay *r = c->replay;
+    if (g->gameOver || g->dir == STOP || g->ticks >= r->ticks) {
+        return false; // With no direction yet, no later move can be due either
+    }
+    if (g->ticks - c->lastMeal >= (unsigned long)g->cells + SNAKE_REPLAY_MAX_IDLE) {
+        c->stalled = true;
+        return false;
+    }
+    SnakeStepResult step = SnakeStep(g, STOP);
+    if (result != NULL) {
+        *result = step;
+    }
+    if (step.events & SNAKE_EVENT_ATE) {
+        c->lastMeal = g->ticks;
+    }
+    SteerDue(c, g);
+    return true;
+}
+
+bool SnakeReplayKeyframeRead(const SnakeReplay *r, int k, SnakeGame *g) {
+    const uint8_t *end = r->moves + r->movesSize;
+    const uint8_t *p = r->moves + r->keyframes[k].offset;
+    uint64_t v, size;
+    GetVarint(&p, end, &v); // Both checked by SnakeReplayOpen()
+    GetVarint(&p, end, &size);
+    return SnakeSnapshotRead(g, p, (size_t)size) && g->ticks == r->keyframes[k].tick;
+}
+
+// --- Restore keyframe k and carry on from it; false if it does not load ---
+static bool RestoreKeyframe(SnakeReplayCursor *c, SnakeGame *g, int k) {
+    if (!SnakeReplayKeyframeRead(c->replay, k, g)) {
+        return false;
+    }
+    // Past the keyframe record: its varint header, then the image
+    const uint8_t *end = c->replay->moves + c->replay->movesSize;
+    const uint8_t *p = c->replay->moves + c->replay->keyframes[k].offset;
+    uint64_t v, size;
+    GetVarint(&p, end, &v);
+    GetVarint(&p, end, &size);
+    c->at = p + size;
+    c->nextTick = c->replay->keyframes[k].tick;
+    c->lastMeal = c->nextTick;
+    c->stalled = false;
+    NextMove(c);
+    SteerDue(c, g);
+    return true;
+}
+
+bool SnakeReplaySeek(SnakeReplayCursor *c, SnakeGame *g, unsigned long tick) {
+    const SnakeReplay *r = c->replay;
+    // Last keyframe at or before the target
+    int lo = 0;
+    int hi = r->nKeyframes;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (r->keyframes[mid].tick <= tick) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    int k = lo - 1;
+    unsigned long from = k >= 0 ? r->keyframes[k].tick : 0;
+    if (g->ticks > tick || g->ticks < from) {
+        bool restored = false;
+        for (; k >= 0 && !restored; k--) {
+            restored = RestoreKeyframe(c, g, k);
+        }
+        if (!restored) {
+            SnakeReplayStart(c, r, g);
+        }
+    }
+    while (g->ticks < tick) {
+        if (!SnakeReplayStep(c, g, NULL)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SnakeReplayMatches(const SnakeReplay *r, const SnakeGame *g) {
+    return r->complete && g->ticks == r->ticks && g->score == r->score && g->hash == r->hash;
+}
@@ -0,0 +1,128 @@
+#ifndef SNAKE_REPLAY_H
+#define SNAKE_REPLAY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "engine.h"
+
+// --- Deterministic Replays ---
+// A game is fully determined by its board size, its seed and the ticks at
+// which its direction changed, so that is all a replay stores. A file is
+// an append-only sequence of games, each:
+//
+//   header    "SNKR", format version, width and height (varints), seed (8 bytes)
+//   records   varint (ticks since the previous record << 3 | kind), where kind
+//             is an enum eDirection for a move, or 5 for a keyframe followed
+//             by a varint size and a SnakeSnapshotWrite() image of the game
+//   end       varint (ticks since the last record << 3 | 0), then varint
+//             score and the final SnakeHash() (8 bytes)
+//   index     varint keyframe count, then per keyframe varint deltas of its
+//             tick and of its record's offset from the first record
+//   trailer   index size in bytes (4 bytes) and "SNKI"
+//
+// Fixed-size fields are little-endian. A keyframe at tick t holds the game
+// as the step from t is about to run, after any move recorded for t, so
+// seeking restores the nearest keyframe and simulates the rest. Version 1
+// files have no keyframes, index or trailer and still play.
+//
+// Without keyframes a typical game is a few hundred bytes. The recorder
+// buffers in memory and only writes when the buffer fills or a game ends,
+// so recording costs no system call per tick.
+
+#define SNAKE_REPLAY_VERSION 2
+#define SNAKE_REPLAY_KEYFRAME_TICKS 1000 // Default keyframe interval
+#define SNAKE_REPLAY_MAX_IDLE 100000     // Ticks past the board area a replay may go without eating
+#define SNAKE_REPLAY_MAX_CELLS (1 << 20) // Largest board worth simulating: 13 MB a game, far past any real one
+
+// --- Recording ---
+typedef struct SnakeRecorder SnakeRecorder;
+
+// keyframeTicks is the keyframe interval, 0 for none. Truncates the file;
+// NULL on failure.
+SnakeRecorder *SnakeRecorderOpen(const char *path, unsigned long keyframeTicks);
+int SnakeRecorderClose(SnakeRecorder *rec);            // Flush and close; 0, or -1 if a write failed
+
+// Call SnakeRecorderBegin() after SnakeReset(), SnakeRecorderTick() right
+// before every SnakeStep() (after steering, so pass that step STOP), and
+// SnakeRecorderEnd() when the game is over or abandoned. End also records
+// a steer made since the last tick, which the final hash includes.
+void SnakeRecorderBegin(SnakeRecorder *rec, const SnakeGame *game);
+void SnakeRecorderTick(SnakeRecorder *rec, const SnakeGame *game);
+void SnakeRecorderEnd(SnakeRecorder *rec, const SnakeGame *game);
+
+// --- Playback ---
+typedef struct {
+    unsigned long tick;
+    size_t offset;            // Of the keyframe record, from the first record
+} SnakeReplayKeyframe;
+
+typedef struct {
+    int width, height;
+    uint64_t seed;
+    const uint8_t *data;      // The whole game, from its header to its trailer
+    size_t dataSize;
+    const uint8_t *moves;     // Move records
+    size_t movesSize;
+    unsigned long ticks;      // Final tick count, or the last record's if not complete
+    bool complete;            // Has an end record; score and hash are set
+    int score;
+    uint64_t hash;            // Final SnakeHash()
+    const SnakeReplayKeyframe *keyframes; // In tick order
+    int nKeyframes;
+} SnakeReplay;
+
+typedef struct {
+    const uint8_t *data;      // The whole file
+    size_t size;
+    uint8_t *owned;           // data, when it was read from a file
+    int count;                // Games in the file
+    SnakeReplay *games;
+    SnakeReplayKeyframe *keyframes; // Every game's, back to back
+} SnakeReplayFile;
+
+SnakeReplayFile *SnakeReplayOpen(const char *path);    // NULL if missing or malformed
+// Parses replay bytes in place, without copying; data must outlive the file.
+SnakeReplayFile *SnakeReplayOpenMemory(const void *data, size_t size);
+void SnakeReplayClose(SnakeReplayFile *file);
+
+// --- Step a game through a replay ---
+typedef struct {
+    const SnakeReplay *replay;
+    const uint8_t *at;        // Next move record
+    unsigned long nextTick;   // Tick of the next move, ULONG_MAX if none
+    enum eDirection nextDir;
+    unsigned long lastMeal;   // Tick the snake last ate, or the replay was started or restored
+    bool stalled;             // Stopped for going too long without eating
+} SnakeReplayCursor;
+
+// Resets game (same size as the replay) to the replay's start.
+void SnakeReplayStart(SnakeReplayCursor *cursor, const SnakeReplay *replay, SnakeGame *game);
+
+// Plays the next tick and stores what it changed in result (may be NULL).
+// Returns false, without stepping, once the replay is over: the game ended
+// or the replay's final tick was reached. Replays are untrusted, and one
+// can claim any number of ticks of a snake circling a row, so it also stops
+// (and sets stalled) once the snake has gone its board area plus
+// SNAKE_REPLAY_MAX_IDLE ticks without eating. A snake heading for the food
+// reaches it within the board area, and the slack is nearly three hours of
+// the TUI's ten ticks a second, so no real game gets there; a hostile one
+// costs at most that much work per food.
+bool SnakeReplayStep(SnakeReplayCursor *cursor, SnakeGame *game, SnakeStepResult *result);
+
+// Moves game to the given tick: restores the last keyframe at or before it
+// (or carries on from the current position when that is closer) and steps
+// the rest headlessly. Returns false if the replay ends first, leaving the
+// game at its last tick.
+bool SnakeReplaySeek(SnakeReplayCursor *cursor, SnakeGame *game, unsigned long tick);
+
+// Loads keyframe k of replay into game (same size as the replay): the game
+// as it was at that keyframe's tick. False if the image does not load.
+bool SnakeReplayKeyframeRead(const SnakeReplay *replay, int k, SnakeGame *game);
+
+// Whether a game played to the end of a complete replay matches its
+// recorded ticks, score and hash.
+bool SnakeReplayMatches(const SnakeReplay *replay, const SnakeGame *game);
+
+#endif
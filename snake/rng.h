@@ -0,0 +1,57 @@
+#ifndef SNAKE_RNG_H
+#define SNAKE_RNG_H
+
+#include <stdint.h>
+
+// --- Per-game random number generator ---
+// xoshiro256** seeded through splitmix64. The whole state is 32 bytes
+// inside each game, so games never share hidden libc state and the same
+// seed gives the same sequence on every thread and platform.
+typedef struct {
+    uint64_t s[4];
+} SnakeRng;
+
+static inline uint64_t SnakeRngRotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// --- Expand a 64-bit seed into a full state (any seed, even 0, is fine) ---
+static inline void SnakeRngSeed(SnakeRng *rng, uint64_t seed) {
+    for (int i = 0; i < 4; i++) {
+        uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        rng->s[i] = z ^ (z >> 31);
+    }
+}
+
+static inline uint64_t SnakeRngNext(SnakeRng *rng) {
+    uint64_t *s = rng->s;
+    uint64_t result = SnakeRngRotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = SnakeRngRotl(s[3], 45);
+    return result;
+}
+
+// --- Uniform value in [0, bound) without modulo bias (Lemire's method) ---
+// The common case is one multiply; the division only runs when the first
+// draw lands in the small biased zone.
+static inline uint32_t SnakeRngBounded(SnakeRng *rng, uint32_t bound) {
+    uint64_t m = (SnakeRngNext(rng) >> 32) * (uint64_t)bound;
+    uint32_t low = (uint32_t)m;
+    if (low < bound) {
+        uint32_t threshold = -bound % bound;
+        while (low < threshold) {
+            m = (SnakeRngNext(rng) >> 32) * (uint64_t)bound;
+            low = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+#endif
@@ -1,306 +1,1048 @@
+#define _GNU_SOURCE   // For ppoll()
 #include <stdio.h>
 #include <stdlib.h>
 #include <ncurses.h>  // For terminal UI functions on Linux/Unix
-#include <unistd.h>   // For usleep()
-#include <time.h>     // For seeding the random number generator
-#include <sys/time.h> // For gettimeofday() to create a responsive game loop
+#include <unistd.h>   // For STDIN_FILENO
+#include <poll.h>     // For ppoll() to sleep until a key or the next deadline
+#include <time.h>     // For clock_gettime() and seeding the random number generator
 #include <stdbool.h>  // For bool type
 #include <string.h>   // For strlen() to center text
+#include <math.h>     // For INFINITY from the solver
+#include <stdarg.h>   // For TermPrint()
+#include <errno.h>    // For retrying interrupted writes
+#include <termios.h>  // For raw keyboard input in the ANSI backend
+#include <sys/ioctl.h> // For the terminal size in the ANSI backend
+#include <signal.h>   // For saving the game on hangup (--save)
+#include "engine.h"   // Game rules and state
+#include "autopilot.h" // Hamiltonian-cycle player for --autopilot
+#include "mcts.h"      // Tree-search player for --autopilot mcts
+#include "solver.h"    // Exact small-board player for --solver
+#include "replay.h"    // --record and --replay
+#include "state.h"     // --save and --resume
 
 // --- Game Configuration ---
-#define WIDTH 40
+#define WIDTH 40          // Board size unless --size or --solver picks another
 #define HEIGHT 20
 #define GAME_SPEED 100000 // microseconds (100000us = 100ms)
+#define MAX_CATCH_UP 5    // Late ticks run back-to-back before the schedule is reset
+#define HIST_BUCKETS 20   // Power-of-two microsecond buckets for timing statistics
+#define MCTS_BUDGET (GAME_SPEED * 6 / 10) // microseconds of search per tick
+#define REPLAY_MAX_SPEED 64 // Fastest replay playback, in ticks per GAME_SPEED
+#define REPLAY_SKIP 1000    // Ticks jumped by '[' and ']' in a replay
 
 // --- Game State Variables ---
-int gameOver;
-int score;
-int headX, headY;       // Snake head coordinates
-int foodX, foodY;       // Food coordinates
-int tailX[100], tailY[100]; // Arrays to store tail coordinates
-int nTail;              // Current length of the tail
-enum eDirection { STOP = 0, LEFT, RIGHT, UP, DOWN };
-enum eDirection dir;
+int boardWidth = WIDTH;
+int boardHeight = HEIGHT;
+SnakeGame *game;        // Board and rules, see engine.h
+bool quit;              // The player asked to leave the current game
+SnakeCycle *cyclePilot; // Steers every tick when set (--autopilot)
+SnakeMcts *mctsPilot;   // Steers every tick when set (--autopilot mcts)
+SnakeSolverTable *solver; // Shows the best move (--solver), and plays it with --autopilot solver
+bool solverPilot;
+SnakeRecorder *recorder;  // Records every game when set (--record)
+SnakeReplayFile *replay;  // Games played back instead of read from the keys (--replay)
+SnakeReplayCursor replayCursor;
+int replayGame;           // Game of the replay file being shown
+int replaySpeed = 1;      // Replay ticks per game tick
+bool paused;              // Replay playback is stopped (space, stepping or the end), or a resumed game waits
+bool redraw;              // Input changed the board outside Logic()
+SnakeGame *resumed;       // Saved game the first game carries on from (--resume)
+volatile sig_atomic_t hangup; // SIGHUP or SIGTERM arrived; save and leave (--save)
 
-// --- Helper function to check if a coordinate is on the snake ---
-bool isPositionOnSnake(int x, int y) {
-    if (headX == x && headY == y) {
-        return true;
+// --- Screen State ---
+char *shown;            // Character currently on screen for each cell
+int *dirtyCells;        // Cells whose character may have changed since the last frame
+unsigned char *isDirty; // 1 for each cell already listed in dirtyCells
+int nDirty;             // Number of entries in dirtyCells
+int shownScore;         // Score currently on screen
+void *arena;            // Single allocation backing the screen arrays above
+
+// --- Terminal Backends ---
+// Drawing and key reading go through one of these. ncurses is the default;
+// the ANSI backend writes escape sequences straight to the terminal.
+typedef struct {
+    bool (*init)(void);
+    void (*end)(void);
+    void (*size)(int *rows, int *cols);
+    void (*clearScreen)(void);
+    void (*put)(int row, int col, const char *text); // Draw text at a screen position
+    void (*flush)(void);                             // Show everything drawn so far
+    int (*getKey)(bool wait);                        // Next key, or ERR if none (and !wait)
+} Backend;
+
+const Backend *term;
+
+// --- Draw formatted text at a screen position through the active backend ---
+void TermPrint(int row, int col, const char *fmt, ...) {
+    char text[128];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(text, sizeof(text), fmt, ap);
+    va_end(ap);
+    term->put(row, col, text);
+}
+
+// --- ncurses backend ---
+bool CursesInit() {
+    initscr();
+    noecho();
+    cbreak();
+    curs_set(0);
+    keypad(stdscr, TRUE);
+    nodelay(stdscr, TRUE);
+    return true;
+}
+
+void CursesEnd() {
+    curs_set(1);
+    endwin();
+}
+
+void CursesSize(int *rows, int *cols) {
+    getmaxyx(stdscr, *rows, *cols);
+}
+
+void CursesClear() {
+    clear();
+}
+
+void CursesPut(int row, int col, const char *text) {
+    mvaddstr(row, col, text);
+}
+
+void CursesFlush() {
+    refresh();
+}
+
+int CursesGetKey(bool wait) {
+    nodelay(stdscr, !wait);
+    return getch();
+}
+
+const Backend cursesBackend = {
+    CursesInit, CursesEnd, CursesSize, CursesClear, CursesPut, CursesFlush, CursesGetKey
+};
+
+// --- ANSI backend ---
+// The screen is kept twice: back is what the game has drawn, front is what
+// the terminal shows. A flush diffs the two, turns each changed run into
+// one cursor move plus its characters, and hands the frame to a single
+// write(). Gaps of a few unchanged cells inside a run are rewritten rather
+// than jumped over, since a cursor move costs more bytes than they do.
+#define ANSI_ROWS (boardHeight + 5)
+#define ANSI_COLS (boardWidth + 2 > 56 ? boardWidth + 2 : 56)
+#define ANSI_GAP 4 // Unchanged cells cheaper to rewrite than to jump over
+
+struct {
+    char *front, *back;   // ANSI_ROWS x ANSI_COLS characters
+    char *out;            // Frame being assembled for write()
+    int cursorRow, cursorCol; // Where the terminal cursor is, -1 if unknown
+    struct termios saved; // Terminal mode to restore on exit
+    unsigned char in[64]; // Pending input bytes
+    int nIn;
+    unsigned long frames; // Non-empty frames written
+    unsigned long bytes;  // Bytes written across those frames
+    unsigned long maxBytes;
+} ansi;
+
+// --- Write a whole buffer, retrying on partial writes ---
+void WriteAll(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+}
+
+bool AnsiInit() {
+    if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO) ||
+        tcgetattr(STDIN_FILENO, &ansi.saved) != 0) {
+        return false;
     }
-    for (int i = 0; i < nTail; i++) {
-        if (tailX[i] == x && tailY[i] == y) {
-            return true;
+    size_t cells = (size_t)ANSI_ROWS * ANSI_COLS;
+    ansi.front = malloc(2 * cells + cells * 16);
+    if (ansi.front == NULL) {
+        return false;
+    }
+    ansi.back = ansi.front + cells;
+    ansi.out = ansi.back + cells; // Worst case is a cursor move per cell
+    memset(ansi.front, ' ', 2 * cells);
+    ansi.cursorRow = ansi.cursorCol = -1;
+
+    // Unbuffered input without echo; keep signals so Ctrl-C still works
+    struct termios raw = ansi.saved;
+    raw.c_lflag &= ~(ICANON | ECHO);
+    raw.c_cc[VMIN] = 0;
+    raw.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+
+    // Alternate screen, hidden cursor, cleared
+    const char *start = "\x1b[?1049h\x1b[?25l\x1b[2J";
+    WriteAll(STDOUT_FILENO, start, strlen(start));
+    return true;
+}
+
+void AnsiEnd() {
+    const char *stop = "\x1b[?25h\x1b[?1049l";
+    WriteAll(STDOUT_FILENO, stop, strlen(stop));
+    tcsetattr(STDIN_FILENO, TCSANOW, &ansi.saved);
+    free(ansi.front);
+}
+
+void AnsiSize(int *rows, int *cols) {
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0) {
+        *rows = ws.ws_row;
+        *cols = ws.ws_col;
+    } else {
+        *rows = 24;
+        *cols = 80;
+    }
+}
+
+void AnsiClear() {
+    // Clear the terminal now so the front buffer matches a blank screen
+    const char *cls = "\x1b[2J";
+    WriteAll(STDOUT_FILENO, cls, strlen(cls));
+    memset(ansi.front, ' ', 2 * (size_t)ANSI_ROWS * ANSI_COLS);
+    ansi.cursorRow = ansi.cursorCol = -1;
+}
+
+void AnsiPut(int row, int col, const char *text) {
+    if (row < 0 || row >= ANSI_ROWS) {
+        return;
+    }
+    char *line = ansi.back + (size_t)row * ANSI_COLS;
+    for (; *text != '\0' && col < ANSI_COLS; text++, col++) {
+        if (col >= 0) {
+            line[col] = *text;
         }
     }
-    return false;
 }
 
-// --- Function to place food at a valid random position ---
-void PlaceFood() {
-    int attempts = 0;
-    do {
-        // Generate coordinates within the playable area (1 to WIDTH, 1 to HEIGHT)
-        foodX = (rand() % WIDTH) + 1;
-        foodY = (rand() % HEIGHT) + 1;
-        attempts++;
-        // Prevent infinite loop in case the snake fills the entire screen
-        if (attempts > WIDTH * HEIGHT) break;
-    } while (isPositionOnSnake(foodX, foodY));
+void AnsiFlush() {
+    char *out = ansi.out;
+    for (int row = 0; row < ANSI_ROWS; row++) {
+        char *front = ansi.front + (size_t)row * ANSI_COLS;
+        char *back = ansi.back + (size_t)row * ANSI_COLS;
+        int col = 0;
+        while (col < ANSI_COLS) {
+            if (front[col] == back[col]) {
+                col++;
+                continue;
+            }
+
+            // Find where this run ends, bridging short unchanged gaps
+            int end = col + 1;
+            for (int gap = 0; end < ANSI_COLS && gap < ANSI_GAP; end++) {
+                if (front[end] != back[end]) {
+                    gap = 0;
+                } else {
+                    gap++;
+                }
+            }
+            while (front[end - 1] == back[end - 1]) {
+                end--; // Trim the unchanged cells we ran past
+            }
+
+            if (ansi.cursorRow != row || ansi.cursorCol != col) {
+                out += sprintf(out, "\x1b[%d;%dH", row + 1, col + 1);
+            }
+            memcpy(out, back + col, (size_t)(end - col));
+            memcpy(front + col, back + col, (size_t)(end - col));
+            out += end - col;
+            ansi.cursorRow = row;
+            ansi.cursorCol = end;
+            col = end;
+        }
+    }
+
+    size_t len = (size_t)(out - ansi.out);
+    if (len > 0) {
+        WriteAll(STDOUT_FILENO, ansi.out, len);
+        ansi.frames++;
+        ansi.bytes += len;
+        if (len > ansi.maxBytes) ansi.maxBytes = len;
+    }
+}
+
+int AnsiGetKey(bool wait) {
+    if (ansi.nIn == 0) {
+        if (wait) {
+            struct pollfd pfd = { .fd = STDIN_FILENO, .events = POLLIN };
+            poll(&pfd, 1, -1);
+        }
+        ssize_t n = read(STDIN_FILENO, ansi.in, sizeof(ansi.in));
+        if (n <= 0) {
+            return ERR;
+        }
+        ansi.nIn = (int)n;
+    }
+
+    // Arrow keys arrive as ESC [ A..D
+    int key = ansi.in[0];
+    int used = 1;
+    if (key == 0x1b && ansi.nIn >= 3 && ansi.in[1] == '[') {
+        switch (ansi.in[2]) {
+            case 'A': key = KEY_UP;    break;
+            case 'B': key = KEY_DOWN;  break;
+            case 'C': key = KEY_RIGHT; break;
+            case 'D': key = KEY_LEFT;  break;
+        }
+        used = 3;
+    }
+    ansi.nIn -= used;
+    memmove(ansi.in, ansi.in + used, (size_t)ansi.nIn);
+    return key;
+}
+
+const Backend ansiBackend = {
+    AnsiInit, AnsiEnd, AnsiSize, AnsiClear, AnsiPut, AnsiFlush, AnsiGetKey
+};
+
+// --- Queue a cell for the next Draw() ---
+void MarkDirty(int cell) {
+    if (!isDirty[cell]) {
+        isDirty[cell] = 1;
+        dirtyCells[nDirty++] = cell;
+    }
+}
+
+// --- AllocateArena: Creates the game and the screen bookkeeping once ---
+// Everything is sized from the board area, so the snake can grow until it
+// covers every cell without any allocation during play.
+void AllocateArena() {
+    if (arena != NULL) {
+        return; // Reused across restarts
+    }
+    int cells = boardWidth * boardHeight;
+    game = SnakeCreate(boardWidth, boardHeight);
+    arena = malloc((size_t)cells * sizeof(int) + 2 * (size_t)cells);
+    if (game == NULL || arena == NULL) {
+        term->end();
+        fprintf(stderr, "Out of memory allocating a %dx%d board\n", boardWidth, boardHeight);
+        exit(1);
+    }
+    char *p = arena;
+    dirtyCells = (int *)p; p += (size_t)cells * sizeof(int);
+    isDirty = (unsigned char *)p; p += cells;
+    shown = p;
+}
+
+// --- AutopilotMove: The bot's next move, or STOP to leave steering to the keys ---
+enum eDirection AutopilotMove() {
+    if (cyclePilot != NULL) {
+        return SnakeAutopilot(game, cyclePilot);
+    }
+    if (mctsPilot != NULL) {
+        return SnakeMctsMove(mctsPilot, game, NULL);
+    }
+    if (solverPilot) {
+        return SnakeSolverBestMove(solver, game, NULL);
+    }
+    return STOP;
 }
 
 // --- Setup: Initializes the game state for a new game ---
 void Setup() {
-    srand(time(NULL)); // Seed the random number generator
-    gameOver = 0;
-    dir = STOP;
-    headX = WIDTH / 2;
-    headY = HEIGHT / 2;
-    score = 0;
-    nTail = 0;
-    
-    // Place initial food
-    PlaceFood();
+    AllocateArena();
+    if (replay != NULL) {
+        SnakeReplayStart(&replayCursor, &replay->games[replayGame], game);
+        paused = false;
+    } else if (resumed != NULL) {
+        SnakeClone(game, resumed); // Wait for a key before carrying on
+        SnakeDestroy(resumed);
+        resumed = NULL;
+        paused = true;
+    } else {
+        SnakeReset(game, (uint64_t)time(NULL));
+    }
+    if (recorder != NULL) {
+        SnakeRecorderBegin(recorder, game);
+    }
+    quit = false;
+    if (cyclePilot != NULL || mctsPilot != NULL || solverPilot) {
+        SnakeSteer(game, AutopilotMove()); // Start moving without a key
+    }
+    memset(isDirty, 0, (size_t)boardWidth * boardHeight);
+    memset(shown, ' ', (size_t)boardWidth * boardHeight); // DrawBoard() starts from a blank screen
+    nDirty = 0;
+    MarkDirty(SnakeHeadCell(game));
+    for (int i = 0; i < SnakeLength(game) - 1; i++) {
+        MarkDirty(SnakeTailCell(game, i)); // A resumed game starts with a body
+    }
+    if (SnakeFoodCell(game) >= 0) {
+        MarkDirty(SnakeFoodCell(game));
+    }
+}
+
+// --- DrawInstructions: The help line under the score ---
+void DrawInstructions() {
+    if (replay != NULL) {
+        TermPrint(boardHeight + 4, 0, "Game %d/%d: space pause, arrows step, [ ] skip, +- speed",
+                  replayGame + 1, replay->count);
+    } else if (paused) {
+        TermPrint(boardHeight + 4, 0, "Resumed at tick %lu. Press any key to go on.      ", SnakeTicks(game));
+    } else if (cyclePilot != NULL || mctsPilot != NULL || solverPilot) {
+        term->put(boardHeight + 4, 0, "Autopilot is playing. Press 'q' to quit.          ");
+    } else {
+        term->put(boardHeight + 4, 0, "Use WASD or Arrow keys. Press 'q' to quit.        ");
+    }
 }
 
 // --- DrawBoard: Draws the static elements (borders, instructions) once ---
 void DrawBoard() {
-    clear(); // Clear the entire screen once
+    term->clearScreen(); // Clear the entire screen once
     
     // Draw top and bottom borders
-    for (int i = 0; i < WIDTH + 2; i++) {
-        mvprintw(0, i, "#");
-        mvprintw(HEIGHT + 1, i, "#");
+    for (int i = 0; i < boardWidth + 2; i++) {
+        term->put(0, i, "#");
+        term->put(boardHeight + 1, i, "#");
     }
 
     // Draw side borders
-    for (int i = 0; i < HEIGHT + 2; i++) {
-        mvprintw(i, 0, "#");
-        mvprintw(i, WIDTH + 1, "#");
+    for (int i = 0; i < boardHeight + 2; i++) {
+        term->put(i, 0, "#");
+        term->put(i, boardWidth + 1, "#");
     }
     
     // Instructions and score area
-    mvprintw(HEIGHT + 3, 0, "Score: 0   ");
-    mvprintw(HEIGHT + 4, 0, "Use WASD or Arrow keys. Press 'q' to quit.");
-    refresh();
+    term->put(boardHeight + 3, 0, "Score: 0   ");
+    shownScore = 0;
+    DrawInstructions();
+    term->flush();
 }
 
-// --- Clear the entire game area (not including borders) ---
-void ClearGameArea() {
-    for (int i = 1; i <= HEIGHT; i++) {
-        for (int j = 1; j <= WIDTH; j++) {
-            mvprintw(i, j, " ");
-        }
-    }
-    
-    // Redraw borders to ensure they don't get accidentally overwritten
-    // Top and bottom borders
-    for (int i = 0; i < WIDTH + 2; i++) {
-        mvprintw(0, i, "#");
-        mvprintw(HEIGHT + 1, i, "#");
-    }
-    
-    // Side borders
-    for (int i = 0; i < HEIGHT + 2; i++) {
-        mvprintw(i, 0, "#");
-        mvprintw(i, WIDTH + 1, "#");
+// --- DrawHint: The solver's best move and the expected ticks left to fill the board ---
+void DrawHint() {
+    static const char *names[] = { "-", "left", "right", "up", "down" };
+    double ticks;
+    enum eDirection best = SnakeSolverBestMove(solver, game, &ticks);
+    if (best == STOP || ticks == INFINITY) {
+        TermPrint(boardHeight + 3, 16, "Best: %-5s (lost)          ", names[best]);
+    } else {
+        TermPrint(boardHeight + 3, 16, "Best: %-5s (%.1f ticks)    ", names[best], ticks);
     }
 }
 
-// --- Draw: Renders the dynamic game elements (snake, food, score) ---
+// --- Draw: Repaints only the cells that changed since the last frame ---
+// Borders and instructions are left to DrawBoard(). A tick dirties at most
+// the new head, the old head, the vacated tail cell and the new food.
 void Draw() {
-    // Clear only the game area, not the borders
-    ClearGameArea();
-    
-    // Draw the food first
-    mvprintw(foodY, foodX, "F");
-    
-    // Draw the snake's tail with bounds checking
-    for (int i = 0; i < nTail; i++) {
-        // Ensure tail segments are within game boundaries
-        if (tailX[i] >= 1 && tailX[i] <= WIDTH && tailY[i] >= 1 && tailY[i] <= HEIGHT) {
-            mvprintw(tailY[i], tailX[i], "o");
+    int head = SnakeHeadCell(game);
+    int food = SnakeFoodCell(game); // -1 once the board is full
+
+    for (int i = 0; i < nDirty; i++) {
+        int cell = dirtyCells[i];
+        isDirty[cell] = 0;
+
+        char c = ' ';
+        if (cell == head) {
+            c = 'O';
+        } else if (SnakeCellOccupied(game, cell)) {
+            c = 'o';
+        } else if (cell == food) {
+            c = 'F';
+        }
+        if (shown[cell] != c) {
+            char text[2] = { c, '\0' };
+            shown[cell] = c;
+            term->put(cell / boardWidth + 1, cell % boardWidth + 1, text);
         }
     }
-    
-    // Draw the snake's head (drawn last so it appears on top) with bounds checking
-    if (headX >= 1 && headX <= WIDTH && headY >= 1 && headY <= HEIGHT) {
-        mvprintw(headY, headX, "O");
+    nDirty = 0;
+
+    // Update the score only when it changes
+    if (SnakeScore(game) != shownScore) {
+        shownScore = SnakeScore(game);
+        TermPrint(boardHeight + 3, 0, "Score: %d   ", shownScore);
+    }
+    if (solver != NULL && !SnakeIsOver(game)) {
+        DrawHint();
+    }
+    if (replay != NULL) {
+        TermPrint(boardHeight + 2, 0, "Tick %lu/%lu  %dx  %s          ", SnakeTicks(game),
+                  replay->games[replayGame].ticks, replaySpeed,
+                  SnakeTicks(game) >= replay->games[replayGame].ticks ? "end" : paused ? "paused" : "");
     }
 
-    // Update the score
-    mvprintw(HEIGHT + 3, 0, "Score: %d   ", score);
+    term->flush(); // Refresh the screen to show changes
+}
 
-    refresh(); // Refresh the screen to show changes
+// --- ReplaySeek: Jumps the replay to a tick and queues a full repaint ---
+// Seeking restores the nearest keyframe and simulates the rest at once,
+// so it never waits on the tick timer.
+void ReplaySeek(long tick) {
+    SnakeReplaySeek(&replayCursor, game, tick > 0 ? (unsigned long)tick : 0);
+    for (int cell = 0; cell < boardWidth * boardHeight; cell++) {
+        MarkDirty(cell);
+    }
+    redraw = true;
+}
+
+// --- ReplayInput: Viewer keys while a replay plays ---
+void ReplayInput(int ch) {
+    long tick = (long)SnakeTicks(game);
+    switch (ch) {
+        case ' ':
+            paused = !paused;
+            redraw = true;
+            break;
+        case KEY_RIGHT:
+        case '.':
+            paused = true;
+            ReplaySeek(tick + 1);
+            break;
+        case KEY_LEFT:
+        case ',':
+            paused = true;
+            ReplaySeek(tick - 1);
+            break;
+        case ']':
+            ReplaySeek(tick + REPLAY_SKIP);
+            break;
+        case '[':
+            ReplaySeek(tick - REPLAY_SKIP);
+            break;
+        case '+':
+        case '=':
+            replaySpeed = replaySpeed < REPLAY_MAX_SPEED ? 2 * replaySpeed : REPLAY_MAX_SPEED;
+            redraw = true;
+            break;
+        case '-':
+            replaySpeed = replaySpeed > 1 ? replaySpeed / 2 : 1;
+            redraw = true;
+            break;
+        case 'q':
+        case 'Q':
+            quit = true;
+            break;
+    }
 }
 
 // --- Input: Handles user keyboard input during the game ---
 void Input() {
     int ch;
     // Process all pending characters in the input buffer.
-    while ((ch = getch()) != ERR) {
+    while ((ch = term->getKey(false)) != ERR) {
+        if (replay != NULL) {
+            ReplayInput(ch); // The recording steers
+            continue;
+        }
+        if (paused) {
+            paused = false; // A resumed game goes on at the first key
+            DrawInstructions();
+            redraw = true;
+        }
         switch (ch) {
             case 'a':
             case 'A':
             case KEY_LEFT:
-                if (dir != RIGHT) dir = LEFT;
+                SnakeSteer(game, LEFT);
                 break;
             case 'd':
             case 'D':
             case KEY_RIGHT:
-                if (dir != LEFT) dir = RIGHT;
+                SnakeSteer(game, RIGHT);
                 break;
             case 'w':
             case 'W':
             case KEY_UP:
-                if (dir != DOWN) dir = UP;
+                SnakeSteer(game, UP);
                 break;
             case 's':
             case 'S':
             case KEY_DOWN:
-                if (dir != UP) dir = DOWN;
+                SnakeSteer(game, DOWN);
                 break;
             case 'q':
             case 'Q':
-                gameOver = 1;
+                quit = true;
                 break;
         }
     }
 }
 
-// --- Logic: Updates the game state based on rules ---
+// --- Logic: Advances the engine one tick and queues the cells it changed ---
+// The move is steered before the step so the recorder sees the direction
+// the step takes.
 void Logic() {
-    if (dir == STOP) return; // Don't move if not started
+    int oldHead = SnakeHeadCell(game);
+    SnakeStepResult r = { 0, false, 0, -1, -1, -1 };
+    if (replay != NULL) {
+        if (!SnakeReplayStep(&replayCursor, game, &r)) {
+            paused = true; // The end: stay to rewind or step back
+            redraw = true;
+        }
+    } else {
+        SnakeSteer(game, AutopilotMove());
+        if (recorder != NULL) {
+            SnakeRecorderTick(recorder, game);
+        }
+        r = SnakeStep(game, STOP);
+    }
+    if (r.events & SNAKE_EVENT_MOVED) {
+        MarkDirty(oldHead); // The old head turns into a body segment on screen
+        MarkDirty(SnakeHeadCell(game));
+    }
+    if (r.vacatedCell >= 0) {
+        MarkDirty(r.vacatedCell);
+    }
+    if (r.foodCell >= 0) {
+        MarkDirty(r.foodCell);
+    }
+}
 
-    // Check if we're about to eat food
-    bool willEatFood = false;
-    int newHeadX = headX;
-    int newHeadY = headY;
-    
-    // Calculate new head position
-    switch (dir) {
-        case LEFT:  newHeadX--; break;
-        case RIGHT: newHeadX++; break;
-        case UP:    newHeadY--; break;
-        case DOWN:  newHeadY++; break;
-        default: break;
+// --- Scheduler: Fixed-timestep tick and render deadlines ---
+// Deadlines are absolute times on CLOCK_MONOTONIC and advance by exactly one
+// period, so a late tick does not push back every tick after it and wall
+// clock changes cannot stall or burst the game.
+typedef struct {
+    long long tickPeriod;      // nanoseconds between ticks
+    long long renderPeriod;    // nanoseconds between frames, 0 to draw after every tick
+    long long nextTick;        // absolute deadline of the next tick
+    long long nextRender;      // absolute deadline of the next frame
+    long long lastLateness;    // lateness of the previous tick, for jitter
+    bool haveLateness;
+    unsigned long ticks;       // ticks run
+    unsigned long dropped;     // ticks skipped when too far behind
+    unsigned long lateness[HIST_BUCKETS]; // how late each tick ran
+    unsigned long jitter[HIST_BUCKETS];   // change in lateness between ticks
+} Scheduler;
+
+Scheduler sched;
+
+// --- Current CLOCK_MONOTONIC time in nanoseconds ---
+long long MonotonicNow() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// --- Bucket 0 is under 1us, bucket i covers [2^(i-1), 2^i) microseconds ---
+int HistBucket(long long ns) {
+    long long us = ns / 1000;
+    int b = 0;
+    while (us > 0 && b < HIST_BUCKETS - 1) {
+        us >>= 1;
+        b++;
     }
-    
-    // Handle wall wrapping - ensure coordinates stay within game area (1 to WIDTH/HEIGHT)
-    if (newHeadX > WIDTH) newHeadX = 1; 
-    else if (newHeadX < 1) newHeadX = WIDTH;
-    if (newHeadY > HEIGHT) newHeadY = 1; 
-    else if (newHeadY < 1) newHeadY = HEIGHT;
-    
-    // Double-check bounds to prevent border corruption
-    if (newHeadX < 1) newHeadX = 1;
-    if (newHeadX > WIDTH) newHeadX = WIDTH;
-    if (newHeadY < 1) newHeadY = 1;
-    if (newHeadY > HEIGHT) newHeadY = HEIGHT;
-    
-    // Check if we will eat food
-    willEatFood = (newHeadX == foodX && newHeadY == foodY);
+    return b;
+}
 
-    // Update tail position: each segment moves to where the one in front was
-    if (nTail > 0) {
-        for (int i = nTail - 1; i > 0; i--) {
-            tailX[i] = tailX[i-1];
-            tailY[i] = tailY[i-1];
-        }
-        tailX[0] = headX; // First tail segment takes head's old position
-        tailY[0] = headY;
+// --- Restart the schedule so the first tick is one period from now ---
+void SchedulerReset(Scheduler *s, long long now) {
+    s->nextTick = now + s->tickPeriod;
+    s->nextRender = now + s->renderPeriod;
+    s->haveLateness = false;
+}
+
+// --- Nanoseconds until the earliest pending deadline (never negative) ---
+long long SchedulerWait(const Scheduler *s, long long now) {
+    long long deadline = s->nextTick;
+    if (s->renderPeriod > 0 && s->nextRender < deadline) {
+        deadline = s->nextRender;
     }
+    return deadline > now ? deadline - now : 0;
+}
 
-    // Move head to new position
-    headX = newHeadX;
-    headY = newHeadY;
+// --- Number of ticks due at time now, advancing the tick deadline ---
+// At most MAX_CATCH_UP ticks are returned. When the game is further behind
+// than that (a suspended terminal, a slow ssh link) the remaining ticks are
+// dropped and the schedule restarts from now instead of bursting.
+int SchedulerDueTicks(Scheduler *s, long long now) {
+    if (now < s->nextTick) {
+        return 0;
+    }
 
-    // Check for self-collision
-    for (int i = 0; i < nTail; i++) {
-        if (tailX[i] == headX && tailY[i] == headY) {
-            gameOver = 1;
-            return;
-        }
+    long long late = now - s->nextTick;
+    s->lateness[HistBucket(late)]++;
+    if (s->haveLateness) {
+        long long delta = late - s->lastLateness;
+        s->jitter[HistBucket(delta < 0 ? -delta : delta)]++;
+    }
+    s->lastLateness = late;
+    s->haveLateness = true;
+
+    long long due = late / s->tickPeriod + 1;
+    if (due > MAX_CATCH_UP) {
+        s->dropped += due - MAX_CATCH_UP;
+        s->nextTick = now + s->tickPeriod;
+        due = MAX_CATCH_UP;
+    } else {
+        s->nextTick += due * s->tickPeriod;
     }
+    s->ticks += due;
+    return (int)due;
+}
 
-    // Handle food eating
-    if (willEatFood) {
-        score += 10;
-        nTail++; // Grow the snake
-        PlaceFood(); // Place new food
+// --- Whether a frame is due; with no render period, only after a tick ---
+bool SchedulerRenderDue(Scheduler *s, long long now, bool ticked) {
+    if (s->renderPeriod == 0) {
+        return ticked;
     }
+    if (now < s->nextRender) {
+        return false;
+    }
+    s->nextRender += s->renderPeriod;
+    if (s->nextRender <= now) {
+        s->nextRender = now + s->renderPeriod; // Skip frames we slept through
+    }
+    return true;
+}
+
+// --- Print the lateness and jitter histograms ---
+void SchedulerDumpStats(const Scheduler *s, FILE *out) {
+    fprintf(out, "Tick timing: %lu ticks, %lu dropped while catching up\n",
+            s->ticks, s->dropped);
+    fprintf(out, "%12s %12s %12s\n", "bucket", "lateness", "jitter");
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        if (s->lateness[i] == 0 && s->jitter[i] == 0) {
+            continue;
+        }
+        char label[32];
+        if (i == 0) {
+            snprintf(label, sizeof(label), "<1us");
+        } else {
+            snprintf(label, sizeof(label), "<%ldus", 1L << i);
+        }
+        fprintf(out, "%12s %12lu %12lu\n", label, s->lateness[i], s->jitter[i]);
+    }
+}
+
+// --- Hangup saving (--save) ---
+// SIGHUP and SIGTERM stay blocked except while the loop sleeps in ppoll(),
+// so they only land between ticks and the game is saved whole. At the game
+// over screen there is nothing to save and they end the process as usual.
+void OnHangup(int sig) {
+    (void)sig;
+    hangup = 1;
+}
+
+void CatchHangups(bool on) {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on ? OnHangup : SIG_DFL;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGHUP, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGHUP);
+    sigaddset(&set, SIGTERM);
+    sigprocmask(on ? SIG_BLOCK : SIG_UNBLOCK, &set, NULL);
+}
+
+// --- Column that centres text of a given length on the board, never off screen ---
+int CenterColumn(int length) {
+    int col = (boardWidth + 2 - length) / 2;
+    return col > 0 ? col : 0;
 }
 
 // --- Main Game Loop ---
-int main() {
-    // --- ncurses setup ---
-    initscr();
-    noecho();
-    cbreak();
-    curs_set(0);
-    keypad(stdscr, TRUE);
-    nodelay(stdscr, TRUE);
+int main(int argc, char *argv[]) {
+    bool showStats = false;
+    bool useAnsi = false;
+    const char *pilot = NULL;
+    const char *solverPath = NULL;
+    const char *recordPath = NULL;
+    const char *replayPath = NULL;
+    const char *savePath = NULL;
+    const char *resumePath = NULL;
+    bool sized = false;
+    int fps = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--stats") == 0) {
+            showStats = true;
+        } else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            fps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--ansi") == 0) {
+            useAnsi = true;
+        } else if (strcmp(argv[i], "--autopilot") == 0) {
+            pilot = "cycle";
+            if (i + 1 < argc && (strcmp(argv[i + 1], "cycle") == 0 || strcmp(argv[i + 1], "mcts") == 0 ||
+                                 strcmp(argv[i + 1], "solver") == 0)) {
+                pilot = argv[++i];
+            }
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc &&
+                   sscanf(argv[i + 1], "%dx%d", &boardWidth, &boardHeight) == 2 &&
+                   boardWidth > 0 && boardHeight > 0) {
+            sized = true;
+            i++;
+        } else if (strcmp(argv[i], "--solver") == 0 && i + 1 < argc) {
+            solverPath = argv[++i];
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+            savePath = argv[++i];
+        } else if (strcmp(argv[i], "--resume") == 0 && i + 1 < argc) {
+            resumePath = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--stats] [--fps N] [--ansi] [--size WxH] [--solver FILE]\n"
+                            "          [--autopilot [cycle|mcts|solver]] [--record FILE | --replay FILE]\n"
+                            "          [--save FILE] [--resume FILE]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (replayPath != NULL) {
+        if (pilot != NULL || recordPath != NULL) {
+            fprintf(stderr, "--replay cannot be combined with --autopilot or --record\n");
+            return 1;
+        }
+        replay = SnakeReplayOpen(replayPath);
+        if (replay == NULL || replay->count == 0) {
+            fprintf(stderr, "Could not read the replay %s\n", replayPath);
+            return 1;
+        }
+        for (int k = 0; k < replay->count; k++) {
+            if (replay->games[k].width != replay->games[0].width ||
+                replay->games[k].height != replay->games[0].height) {
+                fprintf(stderr, "The games in %s are on different board sizes\n", replayPath);
+                return 1;
+            }
+        }
+        boardWidth = replay->games[0].width;
+        boardHeight = replay->games[0].height;
+    }
+    if (resumePath != NULL) {
+        // A recording starts from a seed, so it cannot pick up a game midway
+        if (replayPath != NULL || recordPath != NULL) {
+            fprintf(stderr, "--resume cannot be combined with --replay or --record\n");
+            return 1;
+        }
+        resumed = SnakeLoadFile(resumePath);
+        if (resumed == NULL) {
+            fprintf(stderr, "Could not load the saved game %s\n", resumePath);
+            return 1;
+        }
+        if (sized && (boardWidth != SnakeWidth(resumed) || boardHeight != SnakeHeight(resumed))) {
+            fprintf(stderr, "The saved game is on a %dx%d board\n", SnakeWidth(resumed), SnakeHeight(resumed));
+            return 1;
+        }
+        boardWidth = SnakeWidth(resumed);
+        boardHeight = SnakeHeight(resumed);
+        sized = true;
+    }
+    if (solverPath != NULL) {
+        solver = SnakeSolverOpen(solverPath);
+        if (solver == NULL) {
+            fprintf(stderr, "Could not load the solver table %s\n", solverPath);
+            return 1;
+        }
+        if (!sized && replay == NULL) {
+            boardWidth = SnakeSolverWidth(solver);
+            boardHeight = SnakeSolverHeight(solver);
+        } else if (boardWidth != SnakeSolverWidth(solver) || boardHeight != SnakeSolverHeight(solver)) {
+            fprintf(stderr, "The solver table is for a %dx%d board\n",
+                    SnakeSolverWidth(solver), SnakeSolverHeight(solver));
+            return 1;
+        }
+    }
+    if (recordPath != NULL) {
+        recorder = SnakeRecorderOpen(recordPath, SNAKE_REPLAY_KEYFRAME_TICKS);
+        if (recorder == NULL) {
+            fprintf(stderr, "Could not create the recording %s\n", recordPath);
+            return 1;
+        }
+    }
+    // Hangups are blocked before any pilot threads start, so the threads
+    // inherit the mask and only the main loop's ppoll() takes them
+    sigset_t sleepMask;       // The mask to sleep with, hangups unblocked
+    sigprocmask(SIG_SETMASK, NULL, &sleepMask);
+    if (savePath != NULL) {
+        CatchHangups(true);
+    }
+    if (pilot != NULL && strcmp(pilot, "solver") == 0) {
+        if (solver == NULL) {
+            fprintf(stderr, "--autopilot solver needs --solver FILE\n");
+            return 1;
+        }
+        solverPilot = true;
+        pilot = NULL;
+    }
+    if (pilot != NULL && strcmp(pilot, "cycle") == 0) {
+        cyclePilot = SnakeCycleOpen(boardWidth, boardHeight, SnakeCycleCacheDir());
+        if (cyclePilot == NULL) {
+            fprintf(stderr, "No Hamiltonian cycle for a %dx%d board\n", boardWidth, boardHeight);
+            return 1;
+        }
+    } else if (pilot != NULL) {
+        SnakeMctsConfig config = { .timeBudgetUs = MCTS_BUDGET, .seed = (uint64_t)time(NULL) };
+        mctsPilot = SnakeMctsCreate(&config, boardWidth, boardHeight);
+        if (mctsPilot == NULL) {
+            fprintf(stderr, "Out of memory for the search tree\n");
+            return 1;
+        }
+    }
+
+    // --- Terminal setup (ncurses unless the ANSI backend was asked for and works) ---
+    term = &cursesBackend;
+    if (useAnsi) {
+        if (ansiBackend.init()) {
+            term = &ansiBackend;
+        } else {
+            useAnsi = false;
+        }
+    }
+    if (!useAnsi) {
+        term->init();
+    }
 
     // Check if terminal is large enough
     int max_y, max_x;
-    getmaxyx(stdscr, max_y, max_x);
-    if (max_y < HEIGHT + 6 || max_x < WIDTH + 2) {
-        endwin();
-        printf("Terminal too small! Need at least %dx%d\n", WIDTH + 2, HEIGHT + 6);
+    term->size(&max_y, &max_x);
+    if (max_y < boardHeight + 6 || max_x < boardWidth + 2) {
+        term->end();
+        printf("Terminal too small! Need at least %dx%d\n", boardWidth + 2, boardHeight + 6);
         return 1;
     }
 
-    // --- Time-based loop variables ---
-    struct timeval last_update, current_time;
-    long elapsed_time;
+    // --- Fixed-timestep scheduler ---
+    sched.tickPeriod = GAME_SPEED * 1000LL;
+    sched.renderPeriod = fps > 0 ? 1000000000LL / fps : 0;
 
     bool playing = true;
+    bool saved = false;
+    bool saveFailed = false;
     do {
         Setup();
         DrawBoard();
-        gettimeofday(&last_update, NULL);
+        Draw(); // Show the snake and food before the first move
+        SchedulerReset(&sched, MonotonicNow());
+
+        // A replay stays in the viewer past its end until 'q'
+        while (!quit && (replay != NULL || !SnakeIsOver(game))) {
+            // Sleep until a key arrives or the next deadline. Before the
+            // first move there is nothing to time, so wait for input only.
+            long long now = MonotonicNow();
+            struct timespec timeout;
+            struct timespec *timeoutp = NULL;
+            bool idle = (SnakeDirection(game) == STOP || paused);
+            if (!idle) {
+                long long wait = SchedulerWait(&sched, now);
+                timeout.tv_sec = wait / 1000000000LL;
+                timeout.tv_nsec = wait % 1000000000LL;
+                timeoutp = &timeout;
+            }
+            struct pollfd pfd = { .fd = STDIN_FILENO, .events = POLLIN };
+            ppoll(&pfd, 1, timeoutp, &sleepMask);
+            if (hangup) {
+                break;
+            }
 
-        while (!gameOver) {
             Input();
+            if (redraw) {
+                Draw();
+                redraw = false;
+            }
 
-            gettimeofday(&current_time, NULL);
-            elapsed_time = (current_time.tv_sec - last_update.tv_sec) * 1000000L +
-                           (current_time.tv_usec - last_update.tv_usec);
+            now = MonotonicNow();
+            if (idle || paused) {
+                // Start timing from the moment the snake starts moving
+                SchedulerReset(&sched, now);
+                continue;
+            }
 
-            if (elapsed_time >= GAME_SPEED) {
+            int due = SchedulerDueTicks(&sched, now) * replaySpeed;
+            for (int i = 0; i < due && !SnakeIsOver(game) && !paused; i++) {
                 Logic();
+            }
+            if (SchedulerRenderDue(&sched, now, due > 0) || SnakeIsOver(game)) {
                 Draw();
-                last_update = current_time;
             }
         }
 
-        // Game Over Screen
-        nodelay(stdscr, FALSE);
-        
-        mvprintw(HEIGHT / 2, (WIDTH / 2) - 4, "GAME OVER");
+        if (recorder != NULL) {
+            SnakeRecorderEnd(recorder, game);
+        }
+        if (hangup) {
+            if (!SnakeIsOver(game)) {
+                saved = SnakeSaveFile(game, savePath) == 0;
+                saveFailed = !saved;
+            }
+            break;
+        }
+
+        // Game Over Screen (the key wait blocks here, so no timer runs)
+        if (SnakeIsWon(game)) {
+            term->put(boardHeight / 2, CenterColumn(8), "YOU WIN!");
+            TermPrint(boardHeight / 2 + 1, CenterColumn(18), "Filled in %lu ticks", SnakeTicks(game));
+        } else {
+            term->put(boardHeight / 2, CenterColumn(9), "GAME OVER");
+        }
         
         const char* restart_text = "Press 'r' to Restart or 'q' to Quit";
         int text_len = strlen(restart_text);
-        mvprintw(HEIGHT / 2 + 2, (WIDTH + 2 - text_len) / 2, "%s", restart_text);
+        term->put(boardHeight / 2 + 2, CenterColumn(text_len), restart_text);
+        const SnakeReplay *shownReplay = replay != NULL ? &replay->games[replayGame] : NULL;
+        if (shownReplay != NULL && shownReplay->complete && SnakeTicks(game) == shownReplay->ticks) {
+            bool matches = SnakeReplayMatches(shownReplay, game);
+            TermPrint(boardHeight + 4, 0, "Replay %s the recording. 'r' plays the next game.       ",
+                      matches ? "matches" : "DIFFERS FROM");
+        } else if (shownReplay != NULL) {
+            TermPrint(boardHeight + 4, 0, "Stopped at tick %lu of %lu. 'r' plays the next game.       ",
+                      SnakeTicks(game), shownReplay->ticks);
+        }
         
-        refresh();
+        term->flush();
 
+        if (savePath != NULL) {
+            CatchHangups(false);
+        }
         int choice;
         do {
-            choice = getch();
+            choice = term->getKey(true);
         } while (choice != 'r' && choice != 'R' && choice != 'q' && choice != 'Q');
+        if (savePath != NULL) {
+            CatchHangups(true);
+        }
 
         if (choice == 'q' || choice == 'Q') {
             playing = false;
-        } else {
-            nodelay(stdscr, TRUE);
+        } else if (replay != NULL) {
+            replayGame = (replayGame + 1) % replay->count;
         }
 
     } while (playing);
     
-    // --- ncurses cleanup ---
-    curs_set(1);
-    endwin();
+    // --- Terminal cleanup ---
+    term->end();
+    int score = SnakeScore(game);
+    bool won = SnakeIsWon(game);
+    unsigned long ticks = SnakeTicks(game);
+    SnakeDestroy(game);
+    SnakeCycleClose(cyclePilot);
+    SnakeMctsDestroy(mctsPilot);
+    SnakeSolverClose(solver);
+    SnakeReplayClose(replay);
+    bool recordFailed = SnakeRecorderClose(recorder) != 0;
+    free(arena);
 
+    if (saved) {
+        printf("Saved the game to %s; carry on with --resume %s\n", savePath, savePath);
+    } else if (saveFailed) {
+        printf("Could not save the game to %s\n", savePath);
+    }
     printf("Thanks for playing! Final Score: %d\n", score);
+    if (recordFailed) {
+        printf("Could not write all of the recording to %s\n", recordPath);
+    }
+    if (won) {
+        printf("Filled the board in %lu ticks\n", ticks);
+    }
+    if (showStats) {
+        SchedulerDumpStats(&sched, stdout);
+        if (useAnsi && ansi.frames > 0) {
+            printf("ANSI output: %lu frames, %.1f bytes/frame average, %lu max\n",
+                   ansi.frames, (double)ansi.bytes / ansi.frames, ansi.maxBytes);
+        }
+    }
     return 0;
 }
@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "corpus.h"
+
+// --- Replay corpus CLI ---
+// Packs replay files into one corpus, and filters a corpus by score,
+// length, board size and outcome, listing the matches or extracting them
+// into a replay file the TUI's --replay option plays.
+
+static const char *outcomeNames[] = { "abandoned", "died", "won", "invalid" };
+
+static void Usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s build OUT REPLAY... [--threads N]\n"
+            "       %s query CORPUS [--min-score N] [--max-score N] [--min-ticks N] [--max-ticks N]\n"
+            "                [--size WxH] [--outcome died|won|abandoned|invalid]... [--list]\n"
+            "                [--extract FILE] [--threads N]\n",
+            prog, prog);
+}
+
+static double Seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int Build(int argc, char *argv[]) {
+    const char *out = NULL;
+    int threads = 0;
+    int nFiles = 0;
+    SnakeReplayFile **files = calloc((size_t)argc, sizeof(*files));
+    int status = 1;
+    if (files == NULL) {
+        return 1;
+    }
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (out == NULL) {
+            out = argv[i];
+        } else if ((files[nFiles] = SnakeReplayOpen(argv[i])) != NULL) {
+            nFiles++;
+        } else {
+            fprintf(stderr, "Could not read replay %s\n", argv[i]);
+            goto done;
+        }
+    }
+    if (out == NULL || nFiles == 0) {
+        Usage(argv[0]);
+        goto done;
+    }
+
+    double start = Seconds();
+    long long count = SnakeCorpusBuild(out, files, nFiles, threads);
+    if (count < 0) {
+        fprintf(stderr, "Building %s failed: out of memory or disk\n", out);
+        goto done;
+    }
+    printf("Wrote %s: %lld games in %.2fs\n", out, count, Seconds() - start);
+    status = 0;
+done:
+    for (int i = 0; i < nFiles; i++) {
+        SnakeReplayClose(files[i]);
+    }
+    free(files);
+    return status;
+}
+
+static int Query(int argc, char *argv[]) {
+    SnakeCorpusQuery query = SnakeCorpusQueryAll();
+    const char *path = NULL;
+    const char *extract = NULL;
+    bool list = false;
+    int threads = 0;
+    int outcomes = 0;
+
+    for (int i = 2; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--min-score") == 0 && hasValue) {
+            query.minScore = strtoll(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--max-score") == 0 && hasValue) {
+            query.maxScore = strtoll(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--min-ticks") == 0 && hasValue) {
+            query.minTicks = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--max-ticks") == 0 && hasValue) {
+            query.maxTicks = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--size") == 0 && hasValue &&
+                   sscanf(argv[i + 1], "%dx%d", &query.width, &query.height) == 2) {
+            i++;
+        } else if (strcmp(argv[i], "--outcome") == 0 && hasValue) {
+            const char *name = argv[++i];
+            int k = 0;
+            while (k < 4 && strcmp(name, outcomeNames[k]) != 0) {
+                k++;
+            }
+            if (k == 4) {
+                Usage(argv[0]);
+                return 1;
+            }
+            outcomes |= 1 << k;
+        } else if (strcmp(argv[i], "--list") == 0) {
+            list = true;
+        } else if (strcmp(argv[i], "--extract") == 0 && hasValue) {
+            extract = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && hasValue) {
+            threads = atoi(argv[++i]);
+        } else if (path == NULL && argv[i][0] != '-') {
+            path = argv[i];
+        } else {
+            Usage(argv[0]);
+            return 1;
+        }
+    }
+    if (path == NULL) {
+        Usage(argv[0]);
+        return 1;
+    }
+    if (outcomes != 0) {
+        query.outcomes = outcomes;
+    }
+
+    SnakeCorpus *corpus = SnakeCorpusOpen(path);
+    if (corpus == NULL) {
+        fprintf(stderr, "Could not load corpus %s\n", path);
+        return 1;
+    }
+    uint8_t *matches = malloc(corpus->count ? corpus->count : 1);
+    if (matches == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        SnakeCorpusClose(corpus);
+        return 1;
+    }
+    double start = Seconds();
+    uint64_t found = SnakeCorpusFilter(corpus, &query, matches, threads);
+    double elapsed = Seconds() - start;
+
+    int status = 0;
+    FILE *out = NULL;
+    if (extract != NULL && (out = fopen(extract, "wb")) == NULL) {
+        fprintf(stderr, "Could not create %s\n", extract);
+        status = 1;
+    }
+    for (uint64_t i = 0; i < corpus->count && status == 0; i++) {
+        if (!matches[i]) {
+            continue;
+        }
+        if (list) {
+            printf("%llu  %dx%d  seed %llu  score %d  ticks %u  %s\n", (unsigned long long)i,
+                   corpus->width[i], corpus->height[i], (unsigned long long)corpus->seed[i],
+                   corpus->score[i], corpus->ticks[i], outcomeNames[corpus->outcome[i] & 3]);
+        }
+        if (out != NULL) {
+            size_t size;
+            const uint8_t *game = SnakeCorpusGame(corpus, i, &size);
+            if (fwrite(game, 1, size, out) != size) {
+                status = 1;
+            }
+        }
+    }
+    if (out != NULL && fclose(out) != 0) {
+        status = 1;
+    }
+    if (status != 0 && extract != NULL) {
+        fprintf(stderr, "Writing %s failed\n", extract);
+    }
+    printf("%llu of %llu games match (scanned in %.3f ms)\n", (unsigned long long)found,
+           (unsigned long long)corpus->count, elapsed * 1e3);
+    if (out != NULL && status == 0) {
+        printf("Extracted to %s\n", extract);
+    }
+    free(matches);
+    SnakeCorpusClose(corpus);
+    return status;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc >= 2 && strcmp(argv[1], "build") == 0) {
+        return Build(argc, argv);
+    }
+    if (argc >= 2 && strcmp(argv[1], "query") == 0) {
+        return Query(argc, argv);
+    }
+    Usage(argv[0]);
+    return 1;
+}
@@ -0,0 +1,421 @@
+#define _POSIX_C_SOURCE 199309L // For clock_gettime()
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "autopilot.h"
+#include "bitboard.h"
+#include "farm.h"
+#include "mcts.h"
+#include "state.h"
+#include "tt.h"
+
+// --- Headless simulation farm CLI ---
+// Plays a range of seeds with a built-in policy on every core and prints
+// the merged statistics.
+
+// --- random: any direction that does not reverse, chosen uniformly ---
+static void *RandomThreadInit(void *policyCtx, int thread) {
+    (void)policyCtx;
+    SnakeRng *rng = malloc(sizeof(SnakeRng));
+    if (rng != NULL) {
+        SnakeRngSeed(rng, 0x5eed0000ULL + (uint64_t)thread);
+    }
+    return rng;
+}
+
+static enum eDirection RandomPolicy(const SnakeGame *game, void *ctx) {
+    enum eDirection back = SnakeOpposite(game->lastMove);
+    if (back == STOP) {
+        return (enum eDirection)(LEFT + SnakeRngBounded(ctx, 4)); // No move yet, so none reverses
+    }
+    enum eDirection d = (enum eDirection)(LEFT + SnakeRngBounded(ctx, 3));
+    return d >= back ? (enum eDirection)(d + 1) : d; // Skip over the reversal
+}
+
+// --- greedy: step toward the food along the wrapped board, avoiding the body ---
+static int WrappedDistance(int a, int b, int size) {
+    int d = abs(a - b);
+    return d < size - d ? d : size - d;
+}
+
+static enum eDirection GreedyPolicy(const SnakeGame *game, void *ctx) {
+    (void)ctx;
+    int w = SnakeWidth(game);
+    int h = SnakeHeight(game);
+    int head = SnakeHeadCell(game);
+    int food = SnakeFoodCell(game);
+    enum eDirection best = STOP;
+    int bestDistance = -1;
+    for (enum eDirection d = LEFT; d <= DOWN; d++) {
+        if (d == SnakeOpposite(game->lastMove)) {
+            continue;
+        }
+        int next = SnakeNeighbor(game, head, d);
+        if (SnakeCellOccupied(game, next)) {
+            continue;
+        }
+        int distance = food < 0 ? 0 : WrappedDistance(next % w, food % w, w) +
+                                       WrappedDistance(next / w, food / w, h);
+        if (bestDistance < 0 || distance < bestDistance) {
+            best = d;
+            bestDistance = distance;
+        }
+    }
+    return best; // STOP when boxed in: carry on and die
+}
+
+// --- flood: shortest path to the food that leaves room to live, on bitboards ---
+// A move is roomy when the cells still reachable from the new head could
+// hold the whole snake. Among roomy moves the shortest path around the body
+// to the food wins (one distance field from the food serves every move);
+// failing that, the move with the most room.
+typedef struct {
+    SnakeBitboard *bb;
+    int *dist;                // Steps from the food, one per cell
+} Flood;
+
+static void FloodThreadFree(void *ctx) {
+    Flood *f = ctx;
+    if (f != NULL) {
+        SnakeBitboardDestroy(f->bb);
+        free(f->dist);
+        free(f);
+    }
+}
+
+static void *FloodThreadInit(void *policyCtx, int thread) {
+    (void)thread;
+    const SnakeFarmConfig *config = policyCtx;
+    Flood *f = calloc(1, sizeof(Flood));
+    if (f != NULL) {
+        f->bb = SnakeBitboardCreate(config->width, config->height, SNAKE_TOPOLOGY_WRAP);
+        f->dist = malloc((size_t)config->width * config->height * sizeof(int));
+    }
+    if (f == NULL || f->bb == NULL || f->dist == NULL) {
+        FloodThreadFree(f);
+        return NULL;
+    }
+    return f;
+}
+
+static enum eDirection FloodPolicy(const SnakeGame *game, void *ctx) {
+    Flood *f = ctx;
+    SnakeBitboard *bb = f->bb;
+    int head = SnakeHeadCell(game);
+    int food = SnakeFoodCell(game);
+    SnakeBitboardLoad(bb, game);
+    if (game->nTail > 0) {
+        SnakeBitboardSet(bb->open, SnakeTailCell(game, game->nTail - 1)); // Moves away unless eating
+    }
+    if (food >= 0) {
+        SnakeBitboardLayers(bb, food, f->dist);
+    }
+    enum eDirection best = STOP;
+    int bestRoom = 0;
+    int bestDistance = 0;
+    for (enum eDirection d = LEFT; d <= DOWN; d++) {
+        int next = SnakeNeighbor(game, head, d);
+        if (d == SnakeOpposite(game->lastMove) || !SnakeBitboardTest(bb->open, next)) {
+            continue;
+        }
+        SnakeBitboardClear(bb->open, next);
+        int room = SnakeBitboardReachable(bb, next, NULL);
+        SnakeBitboardSet(bb->open, next);
+        room = room < SnakeLength(game) ? room : SnakeLength(game); // Enough is enough
+        int distance = food < 0 ? 0 : f->dist[next] >= 0 ? f->dist[next] : INT_MAX;
+        if (best == STOP || room > bestRoom || (room == bestRoom && distance < bestDistance)) {
+            best = d;
+            bestRoom = room;
+            bestDistance = distance;
+        }
+    }
+    return best;
+}
+
+// --- beam: the best few lines of play, a few moves deep ---
+// Every round restores each kept position from its SnakeState checkpoint
+// into one scratch game, tries its moves and keeps the best BEAM_WIDTH
+// children. The survivors are SnakeStateCopy()s of those children, so a
+// long body is shared, not copied, until its slot is saved over. Restored
+// games rebuild their free cells in cell order, so food eaten during the
+// search lands elsewhere than it will in the real game: like MCTS, the
+// beam plans against plausible food rather than the game's own. A
+// transposition table keyed on SnakeHash() drops children that another
+// move order already reached, so duplicates do not crowd out other lines.
+#define BEAM_WIDTH 8
+#define BEAM_DEPTH 6
+#define BEAM_TT_BYTES (64 << 10)
+
+typedef struct {
+    SnakeState state;         // Zero-initialized until first saved
+    enum eDirection first;    // Move from the root that leads here
+    long value;
+} BeamNode;
+
+typedef struct {
+    SnakeGame *game;          // Scratch
+    SnakeTT *seen;            // Positions reached, valued with the search that reached them
+    int32_t search;
+    BeamNode kept[BEAM_WIDTH];
+    BeamNode children[3 * BEAM_WIDTH]; // No position has more than three moves
+    int order[3 * BEAM_WIDTH];
+} Beam;
+
+static void BeamThreadFree(void *ctx) {
+    Beam *b = ctx;
+    if (b != NULL) {
+        for (int i = 0; i < BEAM_WIDTH; i++) {
+            SnakeStateRelease(&b->kept[i].state);
+        }
+        for (int i = 0; i < 3 * BEAM_WIDTH; i++) {
+            SnakeStateRelease(&b->children[i].state);
+        }
+        SnakeDestroy(b->game);
+        SnakeTTDestroy(b->seen);
+        free(b);
+    }
+}
+
+static void *BeamThreadInit(void *policyCtx, int thread) {
+    (void)thread;
+    const SnakeFarmConfig *config = policyCtx;
+    Beam *b = calloc(1, sizeof(Beam));
+    if (b != NULL) {
+        b->game = SnakeCreate(config->width, config->height);
+        b->seen = SnakeTTCreate(BEAM_TT_BYTES, SNAKE_TT_AGED);
+    }
+    if (b == NULL || b->game == NULL || b->seen == NULL) {
+        BeamThreadFree(b);
+        return NULL;
+    }
+    return b;
+}
+
+// Food first, then closeness to the next food
+static long BeamValue(const SnakeGame *g) {
+    int food = SnakeFoodCell(g);
+    int head = SnakeHeadCell(g);
+    int w = SnakeWidth(g);
+    int distance = food < 0 ? 0 : WrappedDistance(head % w, food % w, w) +
+                                  WrappedDistance(head / w, food / w, SnakeHeight(g));
+    return (long)SnakeScore(g) * g->cells - distance;
+}
+
+static enum eDirection BeamPolicy(const SnakeGame *game, void *ctx) {
+    Beam *b = ctx;
+    for (int i = 1; i < BEAM_WIDTH; i++) {
+        SnakeStateRelease(&b->kept[i].state);
+    }
+    if (!SnakeSave(game, &b->kept[0].state)) {
+        return STOP;
+    }
+    b->kept[0].first = STOP;
+    b->search++;
+    SnakeTTNewSearch(b->seen); // Entries of earlier searches are replaced first
+    int n = 1;
+    for (int round = 0; round < BEAM_DEPTH; round++) {
+        int m = 0;
+        for (int i = 0; i < n; i++) {
+            for (enum eDirection d = LEFT; d <= DOWN; d++) {
+                SnakeGame *g = b->game;
+                SnakeRestore(g, &b->kept[i].state);
+                if (d == SnakeOpposite(g->lastMove) || (SnakeStep(g, d).events & SNAKE_EVENT_DIED)) {
+                    continue;
+                }
+                SnakeTTData data;
+                if (SnakeTTProbe(b->seen, SnakeHash(g), &data) && data.value == b->search) {
+                    continue; // Another move order got here first
+                }
+                SnakeTTStore(b->seen, SnakeHash(g), (SnakeTTData){ b->search, (uint16_t)round, d, 0 });
+                BeamNode *child = &b->children[m];
+                if (!SnakeSave(g, &child->state)) {
+                    continue;
+                }
+                child->first = round == 0 ? d : b->kept[i].first;
+                child->value = SnakeIsWon(g) ? LONG_MAX : BeamValue(g);
+                b->order[m] = m;
+                m++;
+            }
+        }
+        if (m == 0) {
+            break; // Every line dies here: play the best that got this far
+        }
+        // Best first, by insertion: there are at most 24
+        for (int i = 1; i < m; i++) {
+            int k = b->order[i];
+            int j = i;
+            for (; j > 0 && b->children[b->order[j - 1]].value < b->children[k].value; j--) {
+                b->order[j] = b->order[j - 1];
+            }
+            b->order[j] = k;
+        }
+        n = m < BEAM_WIDTH ? m : BEAM_WIDTH;
+        for (int i = 0; i < n; i++) {
+            const BeamNode *child = &b->children[b->order[i]];
+            SnakeStateRelease(&b->kept[i].state);
+            SnakeStateCopy(&b->kept[i].state, &child->state);
+            b->kept[i].first = child->first;
+            b->kept[i].value = child->value;
+        }
+    }
+    return b->kept[0].first;
+}
+
+// --- cycle: the Hamiltonian-cycle autopilot, which always fills the board ---
+static enum eDirection CyclePolicy(const SnakeGame *game, void *ctx) {
+    return SnakeAutopilot(game, ctx);
+}
+
+// --- mcts: one single-threaded search per farm thread (the farm is the parallelism) ---
+typedef struct {
+    SnakeMctsConfig config;
+    int width, height;
+} MctsSetup;
+
+static void *MctsThreadInit(void *policyCtx, int thread) {
+    MctsSetup *setup = policyCtx;
+    SnakeMctsConfig config = setup->config;
+    config.seed += (uint64_t)thread;
+    return SnakeMctsCreate(&config, setup->width, setup->height);
+}
+
+static void MctsThreadFree(void *ctx) {
+    SnakeMctsDestroy(ctx);
+}
+
+static enum eDirection MctsPolicy(const SnakeGame *game, void *ctx) {
+    return ctx != NULL ? SnakeMctsMove(ctx, game, NULL) : STOP;
+}
+
+static double Seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void Usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [--games N] [--seed S] [--threads N] [--size WxH]\n"
+            "          [--policy greedy|random|flood|beam|cycle|mcts] [--max-ticks N] [--chunk N]\n"
+            "          [--mcts-iterations N]\n", prog);
+}
+
+int main(int argc, char *argv[]) {
+    SnakeFarmConfig config = {
+        .width = 40, .height = 20, .firstSeed = 1, .games = 100000,
+        .maxTicks = 1000000, .policy = GreedyPolicy,
+    };
+    const char *policyName = "greedy";
+    MctsSetup mcts = { .config = { .threads = 1, .iterations = 200, .nodes = 1 << 16 } };
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--games") == 0 && hasValue) {
+            config.games = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && hasValue) {
+            config.firstSeed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--threads") == 0 && hasValue) {
+            config.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--chunk") == 0 && hasValue) {
+            config.chunk = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--max-ticks") == 0 && hasValue) {
+            config.maxTicks = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--mcts-iterations") == 0 && hasValue) {
+            mcts.config.iterations = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--size") == 0 && hasValue &&
+                   sscanf(argv[i + 1], "%dx%d", &config.width, &config.height) == 2) {
+            i++;
+        } else if (strcmp(argv[i], "--policy") == 0 && hasValue) {
+            policyName = argv[++i];
+            if (strcmp(policyName, "greedy") == 0) {
+                config.policy = GreedyPolicy;
+            } else if (strcmp(policyName, "random") == 0) {
+                config.policy = RandomPolicy;
+                config.threadInit = RandomThreadInit;
+                config.threadFree = free;
+            } else if (strcmp(policyName, "flood") == 0) {
+                config.policy = FloodPolicy;
+                config.policyCtx = &config; // Its threads size their bitboards from it
+                config.threadInit = FloodThreadInit;
+                config.threadFree = FloodThreadFree;
+            } else if (strcmp(policyName, "beam") == 0) {
+                config.policy = BeamPolicy;
+                config.policyCtx = &config; // Its threads size their scratch games from it
+                config.threadInit = BeamThreadInit;
+                config.threadFree = BeamThreadFree;
+            } else if (strcmp(policyName, "mcts") == 0) {
+                config.policy = MctsPolicy;
+                config.policyCtx = &mcts;
+                config.threadInit = MctsThreadInit;
+                config.threadFree = MctsThreadFree;
+            } else if (strcmp(policyName, "cycle") == 0) {
+                config.policy = CyclePolicy; // The cycle is opened once the size is known
+            } else {
+                Usage(argv[0]);
+                return 1;
+            }
+        } else {
+            Usage(argv[0]);
+            return 1;
+        }
+    }
+    if (config.width < 1 || config.height < 1 || mcts.config.iterations < 1) {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    mcts.width = config.width;
+    mcts.height = config.height;
+    SnakeCycle *cycle = NULL;
+    if (config.policy == CyclePolicy) {
+        cycle = SnakeCycleOpen(config.width, config.height, SnakeCycleCacheDir());
+        if (cycle == NULL) {
+            fprintf(stderr, "No Hamiltonian cycle for a %dx%d board\n", config.width, config.height);
+            return 1;
+        }
+        config.policyCtx = cycle; // Read-only, so every thread shares it
+    }
+
+    SnakeFarmStats stats;
+    double start = Seconds();
+    int failed = SnakeFarmRun(&config, &stats);
+    double elapsed = Seconds() - start;
+    SnakeCycleClose(cycle);
+    if (failed != 0) {
+        fprintf(stderr, "Simulation failed: out of memory or threads\n");
+        return 1;
+    }
+
+    printf("%llu %s games on %dx%d in %.3fs: %.0f games/s, %.2fM ticks/s\n",
+           (unsigned long long)stats.games, policyName, config.width, config.height,
+           elapsed, stats.games / elapsed, stats.ticks / elapsed / 1e6);
+    if (stats.games == 0) {
+        return 0;
+    }
+    printf("wins %llu, deaths %llu, timeouts %llu, steals %llu\n",
+           (unsigned long long)stats.wins, (unsigned long long)stats.deaths,
+           (unsigned long long)stats.timeouts, (unsigned long long)stats.steals);
+    printf("score min %d, mean %.1f, max %d (seed %llu), mean ticks %.1f\n",
+           stats.minScore, (double)stats.totalScore / stats.games, stats.maxScore,
+           (unsigned long long)stats.maxScoreSeed, (double)stats.ticks / stats.games);
+    if (stats.wins > 0) {
+        printf("mean ticks to fill the board %.1f\n", (double)stats.winTicks / stats.wins);
+    }
+    printf("%12s %12s\n", "food eaten", "games");
+    for (int i = 0; i < SNAKE_FARM_SCORE_BUCKETS; i++) {
+        if (stats.foodHist[i] == 0) {
+            continue;
+        }
+        char label[32];
+        if (i == 0) {
+            snprintf(label, sizeof(label), "0");
+        } else {
+            snprintf(label, sizeof(label), "<%ld", 1L << i);
+        }
+        printf("%12s %12llu\n", label, (unsigned long long)stats.foodHist[i]);
+    }
+    return 0;
+}
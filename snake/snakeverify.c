@@ -0,0 +1,200 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "verify.h"
+
+// --- Replay verifier CLI ---
+// Re-simulates every game of some replay files or corpora on every core and
+// prints a verdict per game: whether it reproduces its claimed score and
+// hash, and if not, the keyframe interval it went wrong in. A replay holds
+// no hash between its keyframes, so that interval (up to 1000 ticks) is as
+// close as a divergence can be placed. Exits 0 when every game is valid, 2
+// when any is not.
+
+static void Usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--threads N] [--failures] [--out FILE] REPLAY_OR_CORPUS...\n", prog);
+}
+
+static double Seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+typedef struct {
+    const char *path;
+    SnakeReplayFile *file;    // At most one of these two; neither if the file
+    SnakeCorpus *corpus;      // does not parse, which is one malformed verdict
+    uint64_t count;
+    SnakeVerdict *verdicts;
+} Input;
+
+static void Report(FILE *out, const Input *in, uint64_t i, const SnakeVerdict *v) {
+    if (in->file == NULL && in->corpus == NULL) {
+        fprintf(out, "%s  %s  not a replay file or corpus\n", in->path, SnakeVerdictName(v->verdict));
+        return;
+    }
+    fprintf(out, "%s:%llu  %s  score %d", in->path, (unsigned long long)i,
+            SnakeVerdictName(v->verdict), v->score);
+    if (v->verdict != SNAKE_VERDICT_INCOMPLETE && v->verdict != SNAKE_VERDICT_MALFORMED) {
+        fprintf(out, " (claimed %d)", v->claimedScore);
+    }
+    fprintf(out, "  ticks %lu", v->ticks);
+    switch (v->verdict) {
+    case SNAKE_VERDICT_DIVERGED:
+    case SNAKE_VERDICT_MISMATCH:
+        fprintf(out, "  diverged between checkpoints at ticks %lu and %lu: hash %016llx,"
+                " expected %016llx", v->lastGood, v->divergedAt, (unsigned long long)v->actualHash,
+                (unsigned long long)v->expectedHash);
+        break;
+    case SNAKE_VERDICT_BAD_KEYFRAME:
+        fprintf(out, "  unreadable keyframe at tick %lu", v->divergedAt);
+        break;
+    case SNAKE_VERDICT_ENDED_EARLY:
+        fprintf(out, "  game ended at tick %lu, after the checkpoint at %lu", v->divergedAt, v->lastGood);
+        break;
+    case SNAKE_VERDICT_STALLED:
+        fprintf(out, "  stopped at tick %lu with nothing eaten for longer than a real game goes", v->divergedAt);
+        break;
+    case SNAKE_VERDICT_TOO_LARGE:
+        fprintf(out, "  board over %d cells", SNAKE_REPLAY_MAX_CELLS);
+        break;
+    default:
+        break;
+    }
+    fputc('\n', out);
+}
+
+int main(int argc, char *argv[]) {
+    int threads = 0;
+    bool failuresOnly = false;
+    const char *outPath = NULL;
+    Input *inputs = calloc((size_t)argc, sizeof(Input));
+    int nInputs = 0;
+    int status = 1;
+    if (inputs == NULL) {
+        return 1;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--threads") == 0 && hasValue) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--failures") == 0) {
+            failuresOnly = true;
+        } else if (strcmp(argv[i], "--out") == 0 && hasValue) {
+            outPath = argv[++i];
+        } else if (argv[i][0] == '-') {
+            Usage(argv[0]);
+            goto done;
+        } else {
+            Input *in = &inputs[nInputs++];
+            in->path = argv[i];
+            // A corpus announces itself by its header; anything else is a replay file
+            if ((in->corpus = SnakeCorpusOpen(in->path)) != NULL) {
+                in->count = in->corpus->count;
+            } else if ((in->file = SnakeReplayOpen(in->path)) != NULL) {
+                in->count = (uint64_t)in->file->count;
+            } else {
+                in->count = 1; // One bad submission must not stop the others
+            }
+        }
+    }
+    if (nInputs == 0) {
+        Usage(argv[0]);
+        goto done;
+    }
+    FILE *out = stdout;
+    if (outPath != NULL && (out = fopen(outPath, "w")) == NULL) {
+        fprintf(stderr, "Could not create %s\n", outPath);
+        goto done;
+    }
+
+    // Games of all replay files go in one batch; corpora are verified in place
+    uint64_t fileGames = 0;
+    for (int k = 0; k < nInputs; k++) {
+        inputs[k].verdicts = malloc((inputs[k].count ? inputs[k].count : 1) * sizeof(SnakeVerdict));
+        if (inputs[k].verdicts == NULL) {
+            fprintf(stderr, "Out of memory\n");
+            goto close;
+        }
+        fileGames += inputs[k].file != NULL ? inputs[k].count : 0;
+        if (inputs[k].file == NULL && inputs[k].corpus == NULL) {
+            inputs[k].verdicts[0] = (SnakeVerdict){ SNAKE_VERDICT_MALFORMED, 0, 0, 0, 0, 0, 0, 0 };
+        }
+    }
+    const SnakeReplay **replays = malloc((fileGames ? fileGames : 1) * sizeof(*replays));
+    SnakeVerdict *fileVerdicts = malloc((fileGames ? fileGames : 1) * sizeof(SnakeVerdict));
+    if (replays == NULL || fileVerdicts == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        free(replays);
+        free(fileVerdicts);
+        goto close;
+    }
+    uint64_t at = 0;
+    for (int k = 0; k < nInputs; k++) {
+        for (uint64_t i = 0; inputs[k].file != NULL && i < inputs[k].count; i++) {
+            replays[at++] = &inputs[k].file->games[i];
+        }
+    }
+
+    double start = Seconds();
+    bool failed = SnakeVerifyAll(replays, fileGames, threads, fileVerdicts) != 0;
+    for (int k = 0; k < nInputs && !failed; k++) {
+        if (inputs[k].corpus != NULL) {
+            failed = SnakeVerifyCorpus(inputs[k].corpus, threads, inputs[k].verdicts) != 0;
+        }
+    }
+    double elapsed = Seconds() - start;
+    at = 0;
+    for (int k = 0; k < nInputs; k++) {
+        if (inputs[k].file != NULL) {
+            memcpy(inputs[k].verdicts, fileVerdicts + at, inputs[k].count * sizeof(SnakeVerdict));
+            at += inputs[k].count;
+        }
+    }
+    free(replays);
+    free(fileVerdicts);
+    if (failed) {
+        fprintf(stderr, "Verification ran out of memory\n"); // Not a verdict on any replay
+        goto close;
+    }
+
+    uint64_t total = 0, ticks = 0, counts[SNAKE_VERDICTS] = { 0 };
+    for (int k = 0; k < nInputs; k++) {
+        for (uint64_t i = 0; i < inputs[k].count; i++) {
+            const SnakeVerdict *v = &inputs[k].verdicts[i];
+            counts[v->verdict]++;
+            ticks += v->ticks;
+            if (!failuresOnly || v->verdict != SNAKE_VERDICT_VALID) {
+                Report(out, &inputs[k], i, v);
+            }
+        }
+        total += inputs[k].count;
+    }
+    fprintf(stderr, "Verified %llu games (%llu ticks) in %.3fs: %.0f games/s, %.0f ticks/s\n",
+            (unsigned long long)total, (unsigned long long)ticks, elapsed,
+            elapsed > 0 ? (double)total / elapsed : 0.0, elapsed > 0 ? (double)ticks / elapsed : 0.0);
+    for (int v = 0; v < SNAKE_VERDICTS; v++) {
+        if (counts[v] > 0) {
+            fprintf(stderr, "  %-13s %llu\n", SnakeVerdictName((SnakeVerdictKind)v),
+                    (unsigned long long)counts[v]);
+        }
+    }
+    status = counts[SNAKE_VERDICT_VALID] == total ? 0 : 2;
+close:
+    if (out != stdout && fclose(out) != 0) {
+        fprintf(stderr, "Writing %s failed\n", outPath);
+        status = 1;
+    }
+done:
+    for (int k = 0; k < nInputs; k++) {
+        SnakeReplayClose(inputs[k].file);
+        SnakeCorpusClose(inputs[k].corpus);
+        free(inputs[k].verdicts);
+    }
+    free(inputs);
+    return status;
+}
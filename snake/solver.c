@@ -0,0 +1,736 @@
+#include "solver.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TABLE_MAGIC 0x314c4f53454b4e53ULL // "SNKESOL1"
+#define NO_STATE UINT32_MAX
+
+typedef unsigned __int128 Key;
+
+// --- Board and its symmetry group ---
+// Transform t reflects x if bit 0 is set, reflects y if bit 1 is set and
+// swaps the axes first if bit 2 is set (square boards only). Translations
+// are taken care of by encoding everything relative to the head.
+typedef struct {
+    int width, height, cells;
+    int transforms;
+    int dirMap[8][5];         // enum eDirection under each transform
+} Board;
+
+static const int DX[5] = { 0, -1, 1, 0, 0 };
+static const int DY[5] = { 0, 0, 0, -1, 1 };
+
+static int DirOf(int dx, int dy) {
+    if (dx < 0) return LEFT;
+    if (dx > 0) return RIGHT;
+    if (dy < 0) return UP;
+    return DOWN;
+}
+
+static void Transform(int t, int *dx, int *dy) {
+    if (t & 4) {
+        int s = *dx;
+        *dx = *dy;
+        *dy = s;
+    }
+    if (t & 1) *dx = -*dx;
+    if (t & 2) *dy = -*dy;
+}
+
+static bool BoardInit(Board *b, int width, int height) {
+    if (width < 3 || height < 3 || width * height > SNAKE_SOLVER_MAX_CELLS) {
+        return false;
+    }
+    b->width = width;
+    b->height = height;
+    b->cells = width * height;
+    b->transforms = width == height ? 8 : 4;
+    for (int t = 0; t < 8; t++) {
+        b->dirMap[t][STOP] = STOP;
+        for (int d = LEFT; d <= DOWN; d++) {
+            int dx = DX[d];
+            int dy = DY[d];
+            Transform(t, &dx, &dy);
+            b->dirMap[t][d] = DirOf(dx, dy);
+        }
+    }
+    return true;
+}
+
+// --- A position, relative to the head at (0, 0) ---
+typedef struct {
+    int length;
+    int foodX, foodY;         // In [0, width) x [0, height)
+    int lastMove;             // Kept only for length 1; longer snakes imply it
+    uint8_t dirs[SNAKE_SOLVER_MAX_CELLS]; // dirs[i]: step from segment i - 1 (the head) to segment i
+} State;
+
+static int Wrap(int v, int size) {
+    return ((v % size) + size) % size;
+}
+
+// --- Key layout: length << 122 | food << 116 | lastMove << 112 | dirs ---
+static Key Encode(const Board *b, const State *s, int t) {
+    int fx = s->foodX;
+    int fy = s->foodY;
+    Transform(t, &fx, &fy);
+    fx = Wrap(fx, b->width);
+    fy = Wrap(fy, b->height);
+    Key key = (Key)s->length << 122 | (Key)(fy * b->width + fx) << 116;
+    if (s->length == 1) {
+        key |= (Key)b->dirMap[t][s->lastMove] << 112;
+    }
+    for (int i = 0; i < s->length - 1; i++) {
+        key |= (Key)(b->dirMap[t][s->dirs[i]] - LEFT) << (2 * i);
+    }
+    return key;
+}
+
+static Key Canonical(const Board *b, const State *s) {
+    Key best = Encode(b, s, 0);
+    for (int t = 1; t < b->transforms; t++) {
+        Key k = Encode(b, s, t);
+        if (k < best) best = k;
+    }
+    return best;
+}
+
+static void Decode(const Board *b, Key key, State *s) {
+    s->length = (int)(key >> 122);
+    int food = (int)(key >> 116) & 63;
+    s->foodX = food % b->width;
+    s->foodY = food / b->width;
+    s->lastMove = s->length == 1 ? (int)(key >> 112) & 7 : STOP;
+    for (int i = 0; i < s->length - 1; i++) {
+        s->dirs[i] = (uint8_t)(LEFT + ((int)(key >> (2 * i)) & 3));
+    }
+}
+
+// --- Cells covered by the body behind the head, as a bit mask ---
+// tail gets the last segment (or -1 for a lone head).
+static uint64_t BodyMask(const Board *b, const State *s, int *tail) {
+    uint64_t mask = 0;
+    int x = 0;
+    int y = 0;
+    *tail = -1;
+    for (int i = 0; i < s->length - 1; i++) {
+        x = Wrap(x + DX[s->dirs[i]], b->width);
+        y = Wrap(y + DY[s->dirs[i]], b->height);
+        *tail = y * b->width + x;
+        mask |= 1ULL << *tail;
+    }
+    return mask;
+}
+
+// --- One move from a position ---
+enum { MOVE_ILLEGAL, MOVE_DIES, MOVE_STEPS, MOVE_EATS, MOVE_WINS };
+
+static int Apply(const Board *b, const State *s, int d, State *next) {
+    // A reversal is ignored by SnakeSteer(), so it is not a separate move
+    int back = s->length == 1 ? SnakeOpposite((enum eDirection)s->lastMove) : s->dirs[0];
+    if (d == back) {
+        return MOVE_ILLEGAL;
+    }
+    int hx = Wrap(DX[d], b->width);
+    int hy = Wrap(DY[d], b->height);
+    bool eats = hx == s->foodX && hy == s->foodY;
+    int tail;
+    uint64_t body = BodyMask(b, s, &tail);
+    if (!eats && tail >= 0) {
+        body &= ~(1ULL << tail); // The tail moves out of the way
+    }
+    if (body & (1ULL << (hy * b->width + hx))) {
+        return MOVE_DIES;
+    }
+
+    next->length = s->length + eats;
+    next->lastMove = d;
+    next->dirs[0] = (uint8_t)SnakeOpposite((enum eDirection)d);
+    memcpy(next->dirs + 1, s->dirs, (size_t)(next->length - 2 > 0 ? next->length - 2 : 0));
+    next->foodX = Wrap(s->foodX - DX[d], b->width);
+    next->foodY = Wrap(s->foodY - DY[d], b->height);
+    if (!eats) {
+        return MOVE_STEPS;
+    }
+    return next->length == b->cells ? MOVE_WINS : MOVE_EATS;
+}
+
+// --- A solved layer: sorted keys and their values ---
+typedef struct {
+    Key *keys;
+    float *values;            // Expected ticks to fill the board, INFINITY if lost
+    size_t count;
+} Layer;
+
+static size_t Find(const Layer *layer, Key key) {
+    size_t lo = 0;
+    size_t hi = layer->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (layer->keys[mid] < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo < layer->count && layer->keys[lo] == key ? lo : SIZE_MAX;
+}
+
+static float Lookup(const Board *b, const Layer *layer, const State *s) {
+    size_t i = Find(layer, Canonical(b, s));
+    return i == SIZE_MAX ? INFINITY : layer->values[i];
+}
+
+// --- Expected ticks after eating: the average over where the new food lands ---
+static double AfterEating(const Board *b, const Layer *longer, State *s) {
+    int tail;
+    uint64_t body = BodyMask(b, s, &tail) | 1; // Plus the head at cell 0
+    double sum = 0.0;
+    int free = 0;
+    for (int cell = 0; cell < b->cells; cell++) {
+        if (body & (1ULL << cell)) {
+            continue;
+        }
+        s->foodX = cell % b->width;
+        s->foodY = cell / b->width;
+        sum += Lookup(b, longer, s);
+        free++;
+    }
+    return sum / free;
+}
+
+// --- Value of one move: 1 tick plus what follows, INFINITY if it loses ---
+static double MoveValue(const Board *b, const Layer *same, const Layer *longer, const State *s, int d) {
+    State next;
+    switch (Apply(b, s, d, &next)) {
+        case MOVE_STEPS: return 1.0 + Lookup(b, same, &next);
+        case MOVE_EATS:  return 1.0 + AfterEating(b, longer, &next);
+        case MOVE_WINS:  return 1.0;
+        default:         return INFINITY;
+    }
+}
+
+// --- Run fn over [0, count) on every thread, chunk items at a time ---
+typedef struct {
+    void (*fn)(void *ctx, size_t start, size_t end);
+    void *ctx;
+    size_t count, chunk;
+    atomic_size_t next;
+} ParallelJob;
+
+static void *ParallelWorker(void *arg) {
+    ParallelJob *job = arg;
+    for (;;) {
+        size_t start = atomic_fetch_add_explicit(&job->next, job->chunk, memory_order_relaxed);
+        if (start >= job->count) {
+            return NULL;
+        }
+        size_t end = start + job->chunk < job->count ? start + job->chunk : job->count;
+        job->fn(job->ctx, start, end);
+    }
+}
+
+static void ParallelFor(int threads, size_t count, size_t chunk,
+                        void (*fn)(void *, size_t, size_t), void *ctx) {
+    ParallelJob job = { fn, ctx, count, chunk, 0 };
+    pthread_t ids[threads > 1 ? threads - 1 : 1];
+    int started = 0;
+    for (; started < threads - 1; started++) {
+        if (pthread_create(&ids[started], NULL, ParallelWorker, &job) != 0) {
+            break; // Carry on with fewer threads
+        }
+    }
+    ParallelWorker(&job);
+    for (int k = 0; k < started; k++) {
+        pthread_join(ids[k], NULL);
+    }
+}
+
+// --- Enumeration: every canonical position of one length ---
+// Bodies are walked depth-first from fixed prefixes of their first steps,
+// one prefix per work item. A position is kept only when its own encoding
+// is the smallest of its symmetry class, so each class appears once.
+#define PREFIX_STEPS 3
+
+typedef struct {
+    Key *keys;
+    size_t count, capacity;
+    bool failed;
+} KeyList;
+
+typedef struct {
+    const Board *board;
+    int length;
+    int (*prefixes)[PREFIX_STEPS];
+    int prefixSteps;
+    KeyList *lists;           // One per prefix, concatenated afterwards
+} Enumeration;
+
+static void Push(KeyList *list, Key key) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? 2 * list->capacity : 1024;
+        Key *keys = realloc(list->keys, capacity * sizeof(Key));
+        if (keys == NULL) {
+            list->failed = true;
+            return;
+        }
+        list->keys = keys;
+        list->capacity = capacity;
+    }
+    list->keys[list->count++] = key;
+}
+
+static void EmitFood(const Board *b, State *s, uint64_t body, KeyList *out) {
+    for (int cell = 1; cell < b->cells; cell++) {
+        if (body & (1ULL << cell)) {
+            continue;
+        }
+        s->foodX = cell % b->width;
+        s->foodY = cell / b->width;
+        Key key = Encode(b, s, 0);
+        if (key == Canonical(b, s)) {
+            Push(out, key);
+        }
+    }
+}
+
+static void Walk(const Board *b, State *s, int depth, int x, int y, uint64_t body, KeyList *out) {
+    if (depth == s->length - 1) {
+        if (s->length == 1) {
+            for (int m = STOP; m <= DOWN; m++) {
+                s->lastMove = m;
+                EmitFood(b, s, body, out);
+            }
+        } else {
+            EmitFood(b, s, body, out);
+        }
+        return;
+    }
+    for (int d = LEFT; d <= DOWN; d++) {
+        int nx = Wrap(x + DX[d], b->width);
+        int ny = Wrap(y + DY[d], b->height);
+        uint64_t bit = 1ULL << (ny * b->width + nx);
+        if (body & bit) {
+            continue;
+        }
+        s->dirs[depth] = (uint8_t)d;
+        Walk(b, s, depth + 1, nx, ny, body | bit, out);
+    }
+}
+
+static void EnumerateChunk(void *ctx, size_t start, size_t end) {
+    Enumeration *e = ctx;
+    const Board *b = e->board;
+    for (size_t p = start; p < end; p++) {
+        State s = { .length = e->length, .lastMove = STOP };
+        int x = 0;
+        int y = 0;
+        uint64_t body = 1;
+        bool valid = true;
+        for (int i = 0; i < e->prefixSteps && valid; i++) {
+            int d = e->prefixes[p][i];
+            x = Wrap(x + DX[d], b->width);
+            y = Wrap(y + DY[d], b->height);
+            uint64_t bit = 1ULL << (y * b->width + x);
+            valid = (body & bit) == 0;
+            body |= bit;
+            s.dirs[i] = (uint8_t)d;
+        }
+        if (valid) {
+            Walk(b, &s, e->prefixSteps, x, y, body, &e->lists[p]);
+        }
+    }
+}
+
+static int CompareKeys(const void *a, const void *b) {
+    Key x = *(const Key *)a;
+    Key y = *(const Key *)b;
+    return x < y ? -1 : x > y;
+}
+
+static bool Enumerate(const Board *b, int length, int threads, Layer *layer) {
+    Enumeration e = { b, length, NULL, length - 1 < PREFIX_STEPS ? length - 1 : PREFIX_STEPS, NULL };
+    size_t prefixes = 1;
+    for (int i = 0; i < e.prefixSteps; i++) prefixes *= 4;
+    e.prefixes = malloc(prefixes * sizeof(*e.prefixes));
+    e.lists = calloc(prefixes, sizeof(KeyList));
+    bool ok = e.prefixes != NULL && e.lists != NULL;
+    for (size_t p = 0; ok && p < prefixes; p++) {
+        size_t code = p;
+        for (int i = 0; i < e.prefixSteps; i++, code /= 4) {
+            e.prefixes[p][i] = LEFT + (int)(code % 4);
+        }
+    }
+    if (ok) {
+        ParallelFor(threads, prefixes, 1, EnumerateChunk, &e);
+    }
+
+    size_t total = 0;
+    for (size_t p = 0; ok && p < prefixes; p++) {
+        ok = !e.lists[p].failed;
+        total += e.lists[p].count;
+    }
+    layer->count = total;
+    layer->keys = ok ? malloc((total ? total : 1) * sizeof(Key)) : NULL;
+    layer->values = ok ? malloc((total ? total : 1) * sizeof(float)) : NULL;
+    ok = ok && layer->keys != NULL && layer->values != NULL;
+    size_t at = 0;
+    for (size_t p = 0; e.lists != NULL && p < prefixes; p++) {
+        if (ok && e.lists[p].count > 0) {
+            memcpy(layer->keys + at, e.lists[p].keys, e.lists[p].count * sizeof(Key));
+            at += e.lists[p].count;
+        }
+        free(e.lists[p].keys);
+    }
+    free(e.lists);
+    free(e.prefixes);
+    if (ok) {
+        qsort(layer->keys, total, sizeof(Key), CompareKeys);
+    }
+    return ok;
+}
+
+// --- Expansion: each position's eating value and its moves within the layer ---
+typedef struct {
+    const Board *board;
+    const Layer *layer, *longer;
+    double *exitValue;        // Best value through eating, INFINITY if none
+    uint32_t (*next)[4];      // Positions one step away in this layer
+} Expansion;
+
+static void ExpandChunk(void *ctx, size_t start, size_t end) {
+    Expansion *x = ctx;
+    const Board *b = x->board;
+    for (size_t i = start; i < end; i++) {
+        State s;
+        Decode(b, x->layer->keys[i], &s);
+        double exit = INFINITY;
+        int n = 0;
+        for (int d = LEFT; d <= DOWN; d++) {
+            State next;
+            int kind = Apply(b, &s, d, &next);
+            if (kind == MOVE_STEPS) {
+                x->next[i][n++] = (uint32_t)Find(x->layer, Canonical(b, &next));
+            } else if (kind == MOVE_EATS || kind == MOVE_WINS) {
+                double v = kind == MOVE_WINS ? 1.0 : 1.0 + AfterEating(b, x->longer, &next);
+                if (v < exit) exit = v;
+            }
+        }
+        while (n < 4) {
+            x->next[i][n++] = NO_STATE;
+        }
+        x->exitValue[i] = exit;
+    }
+}
+
+// --- Min-heap of (value, position) for Dijkstra ---
+typedef struct {
+    double value;
+    uint32_t state;
+} HeapItem;
+
+static void HeapPush(HeapItem *heap, size_t *n, HeapItem item) {
+    size_t i = (*n)++;
+    while (i > 0 && heap[(i - 1) / 2].value > item.value) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = item;
+}
+
+static HeapItem HeapPop(HeapItem *heap, size_t *n) {
+    HeapItem top = heap[0];
+    HeapItem last = heap[--*n];
+    size_t i = 0;
+    for (;;) {
+        size_t c = 2 * i + 1;
+        if (c >= *n) break;
+        if (c + 1 < *n && heap[c + 1].value < heap[c].value) c++;
+        if (heap[c].value >= last.value) break;
+        heap[i] = heap[c];
+        i = c;
+    }
+    if (*n > 0) heap[i] = last;
+    return top;
+}
+
+// --- Solve one layer given the next longer one ---
+// value(p) = min(exit(p), 1 + min over p's in-layer moves q of value(q)),
+// so Dijkstra runs backwards along the moves from the eating values.
+static bool SolveLayer(const Board *b, int threads, Layer *layer, const Layer *longer) {
+    size_t n = layer->count;
+    double *dist = malloc((n ? n : 1) * sizeof(double));
+    uint32_t (*next)[4] = malloc((n ? n : 1) * sizeof(*next));
+    size_t *start = calloc(n + 1, sizeof(size_t));
+    uint32_t *from = malloc((4 * n + 1) * sizeof(uint32_t));
+    HeapItem *heap = malloc((5 * n + 1) * sizeof(HeapItem)); // Each push follows an improvement
+    bool ok = dist != NULL && next != NULL && start != NULL && from != NULL && heap != NULL;
+
+    if (ok) {
+        Expansion x = { b, layer, longer, dist, next };
+        ParallelFor(threads, n, 4096, ExpandChunk, &x);
+
+        // Reverse the moves: from[start[q] .. start[q + 1]) are q's predecessors
+        for (size_t i = 0; i < n; i++) {
+            for (int k = 0; k < 4 && next[i][k] != NO_STATE; k++) start[next[i][k] + 1]++;
+        }
+        for (size_t q = 0; q < n; q++) start[q + 1] += start[q];
+        for (size_t i = 0; i < n; i++) {
+            for (int k = 0; k < 4 && next[i][k] != NO_STATE; k++) from[start[next[i][k]]++] = (uint32_t)i;
+        }
+        for (size_t q = n; q > 0; q--) start[q] = start[q - 1];
+        start[0] = 0;
+
+        size_t items = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (dist[i] < INFINITY) HeapPush(heap, &items, (HeapItem){ dist[i], (uint32_t)i });
+        }
+        while (items > 0) {
+            HeapItem top = HeapPop(heap, &items);
+            if (top.value > dist[top.state]) {
+                continue; // Stale
+            }
+            for (size_t k = start[top.state]; k < start[top.state + 1]; k++) {
+                uint32_t p = from[k];
+                if (top.value + 1.0 < dist[p]) {
+                    dist[p] = top.value + 1.0;
+                    HeapPush(heap, &items, (HeapItem){ dist[p], p });
+                }
+            }
+        }
+        for (size_t i = 0; i < n; i++) {
+            layer->values[i] = (float)dist[i];
+        }
+    }
+    free(dist);
+    free(next);
+    free(start);
+    free(from);
+    free(heap);
+    return ok;
+}
+
+// --- Table file ---
+// Header, a directory entry per length 1 .. cells - 1, then each layer's
+// keys (16 bytes each, 16-byte aligned) and values (floats).
+typedef struct {
+    uint64_t magic;
+    int32_t width, height;
+    int32_t layers;
+    int32_t reserved;
+} TableHeader;
+
+typedef struct {
+    uint64_t count;
+    uint64_t keysOffset;
+    uint64_t valuesOffset;
+} TableLayer;
+
+static size_t Align16(size_t n) {
+    return (n + 15) & ~(size_t)15;
+}
+
+static bool WriteAt(int fd, const void *data, size_t size, off_t offset) {
+    const char *p = data;
+    while (size > 0) {
+        ssize_t n = pwrite(fd, p, size, offset);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= (size_t)n;
+        offset += n;
+    }
+    return true;
+}
+
+static double Seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int SnakeSolve(int width, int height, int threads, const char *path, FILE *progress) {
+    Board b;
+    if (!BoardInit(&b, width, height)) {
+        return -1;
+    }
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    char temp[4096];
+    int len = snprintf(temp, sizeof(temp), "%s.%ld.tmp", path, (long)getpid());
+    if (len < 0 || (size_t)len >= sizeof(temp)) {
+        return -1;
+    }
+    int fd = open(temp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+
+    // Layers are solved longest first, streamed to the file as they finish,
+    // and only the one below needs the one above kept in memory.
+    int layers = b.cells - 1;
+    TableLayer *dir = calloc((size_t)layers, sizeof(TableLayer));
+    size_t offset = Align16(sizeof(TableHeader) + (size_t)layers * sizeof(TableLayer));
+    Layer longer = { NULL, NULL, 0 };
+    bool ok = dir != NULL;
+    for (int length = layers; ok && length >= 1; length--) {
+        double t0 = Seconds();
+        Layer layer = { NULL, NULL, 0 };
+        ok = Enumerate(&b, length, threads, &layer) && SolveLayer(&b, threads, &layer, &longer);
+        if (ok) {
+            TableLayer *d = &dir[length - 1];
+            d->count = layer.count;
+            d->keysOffset = offset;
+            d->valuesOffset = Align16(offset + layer.count * sizeof(Key));
+            offset = Align16(d->valuesOffset + layer.count * sizeof(float));
+            ok = WriteAt(fd, layer.keys, layer.count * sizeof(Key), (off_t)d->keysOffset) &&
+                 WriteAt(fd, layer.values, layer.count * sizeof(float), (off_t)d->valuesOffset);
+            if (progress != NULL) {
+                size_t won = 0;
+                for (size_t i = 0; i < layer.count; i++) won += layer.values[i] < INFINITY;
+                fprintf(progress, "length %2d: %10zu positions, %10zu winnable, %.2fs\n",
+                        length, layer.count, won, Seconds() - t0);
+            }
+        }
+        free(longer.keys);
+        free(longer.values);
+        longer = layer;
+    }
+    free(longer.keys);
+    free(longer.values);
+
+    TableHeader header = { TABLE_MAGIC, width, height, layers, 0 };
+    ok = ok && WriteAt(fd, &header, sizeof(header), 0) &&
+         WriteAt(fd, dir, (size_t)layers * sizeof(TableLayer), sizeof(header)) &&
+         ftruncate(fd, (off_t)offset) == 0 && fsync(fd) == 0;
+    ok = close(fd) == 0 && ok;
+    free(dir);
+    if (!ok || rename(temp, path) != 0) {
+        unlink(temp);
+        return -1;
+    }
+    return 0;
+}
+
+// --- Loaded table ---
+struct SnakeSolverTable {
+    Board board;
+    void *map;
+    size_t size;
+    Layer layers[SNAKE_SOLVER_MAX_CELLS]; // layers[length], 1 .. cells - 1
+};
+
+SnakeSolverTable *SnakeSolverOpen(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    void *map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(TableHeader)) {
+        map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+    size_t size = (size_t)st.st_size;
+    SnakeSolverTable *t = calloc(1, sizeof(SnakeSolverTable));
+    const TableHeader *h = map;
+    bool ok = t != NULL && h->magic == TABLE_MAGIC && BoardInit(&t->board, h->width, h->height) &&
+              h->layers == t->board.cells - 1 &&
+              sizeof(TableHeader) + (size_t)h->layers * sizeof(TableLayer) <= size;
+    const TableLayer *dir = (const TableLayer *)(h + 1);
+    for (int length = 1; ok && length <= h->layers; length++) {
+        const TableLayer *d = &dir[length - 1];
+        ok = d->keysOffset % 16 == 0 && d->valuesOffset % 4 == 0 &&
+             d->count <= size / sizeof(Key) && d->keysOffset <= size && d->valuesOffset <= size &&
+             d->keysOffset + d->count * sizeof(Key) <= size &&
+             d->valuesOffset + d->count * sizeof(float) <= size;
+        if (ok) {
+            t->layers[length].keys = (Key *)((char *)map + d->keysOffset);
+            t->layers[length].values = (float *)((char *)map + d->valuesOffset);
+            t->layers[length].count = d->count;
+        }
+    }
+    if (!ok) {
+        munmap(map, size);
+        free(t);
+        return NULL;
+    }
+    t->map = map;
+    t->size = size;
+    return t;
+}
+
+void SnakeSolverClose(SnakeSolverTable *t) {
+    if (t != NULL) {
+        munmap(t->map, t->size);
+        free(t);
+    }
+}
+
+int SnakeSolverWidth(const SnakeSolverTable *t) {
+    return t->board.width;
+}
+
+int SnakeSolverHeight(const SnakeSolverTable *t) {
+    return t->board.height;
+}
+
+enum eDirection SnakeSolverBestMove(const SnakeSolverTable *t, const SnakeGame *g, double *expectedTicks) {
+    const Board *b = &t->board;
+    if (expectedTicks != NULL) {
+        *expectedTicks = INFINITY;
+    }
+    if (SnakeIsOver(g) || g->width != b->width || g->height != b->height || SnakeFoodCell(g) < 0) {
+        return STOP;
+    }
+
+    // The game's position relative to its head
+    State s = { .length = SnakeLength(g), .lastMove = g->lastMove };
+    int head = SnakeHeadCell(g);
+    s.foodX = Wrap(g->foodX - g->headX, b->width);
+    s.foodY = Wrap(g->foodY - g->headY, b->height);
+    int ahead = head;
+    for (int i = 0; i < g->nTail; i++) {
+        int cell = SnakeTailCell(g, i);
+        for (int d = LEFT; d <= DOWN; d++) {
+            if (SnakeNeighbor(g, ahead, (enum eDirection)d) == cell) {
+                s.dirs[i] = (uint8_t)d;
+            }
+        }
+        ahead = cell;
+    }
+
+    const Layer *same = &t->layers[s.length];
+    const Layer *longer = s.length + 1 < b->cells ? &t->layers[s.length + 1] : same;
+    enum eDirection best = STOP;
+    double bestValue = INFINITY;
+    for (int d = LEFT; d <= DOWN; d++) {
+        if (d == (int)SnakeOpposite(g->lastMove)) {
+            continue; // SnakeSteer() would ignore it
+        }
+        double v = MoveValue(b, same, longer, &s, d);
+        if (best == STOP || v < bestValue) {
+            best = (enum eDirection)d;
+            bestValue = v;
+        }
+    }
+    if (expectedTicks != NULL) {
+        *expectedTicks = bestValue;
+    }
+    return best;
+}
@@ -0,0 +1,50 @@
+#ifndef SNAKE_SOLVER_H
+#define SNAKE_SOLVER_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "engine.h"
+
+// --- Exhaustive Solver for Small Boards ---
+// Computes, for every position of a small board, the expected number of
+// ticks to fill it under optimal play, with food landing uniformly on the
+// free cells as in the engine. Positions are solved in layers by snake
+// length, longest first: inside a layer every move either keeps the
+// length (one tick to another position of the layer) or eats (one tick
+// plus the average over the next layer's food placements), so each layer
+// is a shortest-path problem solved with Dijkstra from its eating moves.
+//
+// A position is encoded in 128 bits relative to the head: the length, the
+// food cell and the body as 2-bit directions. Positions equal under a
+// translation of the wrapped board or a reflection or rotation are stored
+// once, under the smallest encoding of the group. Layers are enumerated
+// and expanded by a pool of threads and written to a table file that
+// SnakeSolverOpen() maps into memory.
+//
+// Boards need both sides at least 3 and at most SNAKE_SOLVER_MAX_CELLS
+// cells; in practice 5x5 (about 14 million positions) is the limit.
+
+#define SNAKE_SOLVER_MAX_CELLS 49
+
+// --- Solve a board and write its table (temp file, then rename) ---
+// progress, if not NULL, gets a line per layer. Returns 0, or -1 if the
+// size is unsupported or memory, threads or the file fail.
+int SnakeSolve(int width, int height, int threads, const char *path, FILE *progress);
+
+typedef struct SnakeSolverTable SnakeSolverTable;
+
+// --- Load a table; NULL if it is missing or damaged ---
+SnakeSolverTable *SnakeSolverOpen(const char *path);
+void SnakeSolverClose(SnakeSolverTable *table);
+int SnakeSolverWidth(const SnakeSolverTable *table);
+int SnakeSolverHeight(const SnakeSolverTable *table);
+
+// --- Optimal move for a game on the table's board ---
+// expectedTicks, if not NULL, gets the expected ticks to fill the board
+// after that move (INFINITY if every move loses). Returns STOP if the game
+// is over or on another board size.
+enum eDirection SnakeSolverBestMove(const SnakeSolverTable *table, const SnakeGame *game,
+                                    double *expectedTicks);
+
+#endif
@@ -0,0 +1,370 @@
+#include "state.h"
+#include "cellset.h"
+
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// --- Reference-counted body moves for long snakes ---
+struct SnakeBodyBlock {
+    atomic_int refs;
+    int capacity;             // Segments the block can hold
+    uint8_t moves[];          // 4 moves per byte
+};
+
+// --- Direction of the step from cell a to its neighbour b ---
+static enum eDirection StepBetween(const SnakeGame *g, int a, int b) {
+    for (enum eDirection d = LEFT; d <= DOWN; d++) {
+        if (SnakeNeighbor(g, a, d) == b) {
+            return d;
+        }
+    }
+    return STOP; // Not adjacent; cannot happen for a valid body
+}
+
+static void PutMove(uint8_t *moves, int i, enum eDirection d) {
+    int shift = (i & 3) * 2;
+    moves[i >> 2] = (uint8_t)((moves[i >> 2] & ~(3 << shift)) | ((d - LEFT) << shift));
+}
+
+static enum eDirection GetMove(const uint8_t *moves, int i) {
+    return (enum eDirection)(LEFT + ((moves[i >> 2] >> ((i & 3) * 2)) & 3));
+}
+
+void SnakeStateRelease(SnakeState *state) {
+    SnakeBodyBlock *block = state->shared;
+    if (block != NULL && atomic_fetch_sub_explicit(&block->refs, 1, memory_order_acq_rel) == 1) {
+        free(block);
+    }
+    state->shared = NULL;
+}
+
+void SnakeStateCopy(SnakeState *dst, const SnakeState *src) {
+    *dst = *src;
+    if (dst->shared != NULL) {
+        atomic_fetch_add_explicit(&dst->shared->refs, 1, memory_order_relaxed);
+    }
+}
+
+bool SnakeSave(const SnakeGame *g, SnakeState *s) {
+    uint8_t *moves = s->body;
+    if (g->nTail > SNAKE_STATE_INLINE_SEGMENTS) {
+        // Rewrite the block in place only if this state is its sole owner
+        SnakeBodyBlock *block = s->shared;
+        if (block == NULL || block->capacity < g->nTail ||
+            atomic_load_explicit(&block->refs, memory_order_acquire) != 1) {
+            SnakeStateRelease(s);
+            block = malloc(sizeof(SnakeBodyBlock) + ((size_t)g->cells + 3) / 4);
+            if (block == NULL) {
+                return false;
+            }
+            atomic_init(&block->refs, 1);
+            block->capacity = g->cells;
+            s->shared = block;
+        }
+        moves = block->moves;
+    } else {
+        SnakeStateRelease(s);
+    }
+
+    s->width = g->width;
+    s->height = g->height;
+    s->head = SnakeHeadCell(g);
+    s->food = SnakeFoodCell(g);
+    s->score = g->score;
+    s->nTail = g->nTail;
+    s->ticks = g->ticks;
+    s->seed = g->seed;
+    s->rng = g->rng;
+    s->dir = (uint8_t)g->dir;
+    s->lastMove = (uint8_t)g->lastMove;
+    s->gameOver = g->gameOver;
+    s->gameWon = g->gameWon;
+
+    int prev = s->head;
+    for (int i = 0; i < g->nTail; i++) {
+        int cell = SnakeTailCell(g, i);
+        PutMove(moves, i, StepBetween(g, prev, cell));
+        prev = cell;
+    }
+    return true;
+}
+
+bool SnakeRestore(SnakeGame *g, const SnakeState *s) {
+    if (s->width != g->width || s->height != g->height) {
+        return false;
+    }
+    const uint8_t *moves = s->shared != NULL ? s->shared->moves : s->body;
+
+    g->headX = s->head % g->width;
+    g->headY = s->head / g->width;
+    g->foodX = s->food < 0 ? -1 : s->food % g->width;
+    g->foodY = s->food < 0 ? -1 : s->food / g->width;
+    g->score = s->score;
+    g->nTail = s->nTail;
+    g->tailStart = 0;
+    g->ticks = (unsigned long)s->ticks;
+    g->seed = s->seed;
+    g->rng = s->rng;
+    g->dir = (enum eDirection)s->dir;
+    g->lastMove = (enum eDirection)s->lastMove;
+    g->gameOver = s->gameOver;
+    g->gameWon = s->gameWon;
+
+    CellSetClear(g->freeCells, g->freePos, g->occupied, &g->nFree, g->cells);
+    CellSetOccupy(g->freeCells, g->freePos, g->occupied, &g->nFree, s->head);
+    int cell = s->head;
+    for (int i = 0; i < s->nTail; i++) {
+        cell = SnakeNeighbor(g, cell, GetMove(moves, i));
+        g->tail[i] = cell;
+        if (!g->occupied[cell]) { // Only a dead snake's head can overlap its body
+            CellSetOccupy(g->freeCells, g->freePos, g->occupied, &g->nFree, cell);
+        }
+    }
+    g->hash = SnakeComputeHash(g);
+    return true;
+}
+
+// --- Exact snapshots ---
+// Layout: width, height, head, food, score, nTail, nFree (u32 each; food
+// is -1 without food), dir, lastMove, gameOver, gameWon (u8 each), ticks,
+// seed, hash and the four RNG words (u64 each), then the body from the
+// neck to the tail and the free-cell index in slot order.
+#define SNAPSHOT_HEADER (7 * 4 + 4 + 7 * 8)
+
+static int CellBytes(int cells) {
+    return cells <= 65536 ? 2 : 4;
+}
+
+static uint8_t *PutLE(uint8_t *p, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+    return p + bytes;
+}
+
+static const uint8_t *GetLE(const uint8_t *p, uint64_t *v, int bytes) {
+    *v = 0;
+    for (int i = 0; i < bytes; i++) {
+        *v |= (uint64_t)p[i] << (8 * i);
+    }
+    return p + bytes;
+}
+
+size_t SnakeSnapshotSize(const SnakeGame *g) {
+    return SNAPSHOT_HEADER + (size_t)(g->nTail + g->nFree) * CellBytes(g->cells);
+}
+
+void SnakeSnapshotWrite(const SnakeGame *g, void *buf) {
+    int cb = CellBytes(g->cells);
+    uint8_t *p = buf;
+    p = PutLE(p, (uint32_t)g->width, 4);
+    p = PutLE(p, (uint32_t)g->height, 4);
+    p = PutLE(p, (uint32_t)SnakeHeadCell(g), 4);
+    p = PutLE(p, (uint32_t)SnakeFoodCell(g), 4);
+    p = PutLE(p, (uint32_t)g->score, 4);
+    p = PutLE(p, (uint32_t)g->nTail, 4);
+    p = PutLE(p, (uint32_t)g->nFree, 4);
+    *p++ = (uint8_t)g->dir;
+    *p++ = (uint8_t)g->lastMove;
+    *p++ = g->gameOver;
+    *p++ = g->gameWon;
+    p = PutLE(p, g->ticks, 8);
+    p = PutLE(p, g->seed, 8);
+    p = PutLE(p, g->hash, 8);
+    for (int i = 0; i < 4; i++) {
+        p = PutLE(p, g->rng.s[i], 8);
+    }
+    for (int i = 0; i < g->nTail; i++) {
+        p = PutLE(p, (uint32_t)SnakeTailCell(g, i), cb);
+    }
+    for (int i = 0; i < g->nFree; i++) {
+        p = PutLE(p, (uint32_t)g->freeCells[i], cb);
+    }
+}
+
+bool SnakeSnapshotRead(SnakeGame *g, const void *buf, size_t size) {
+    const uint8_t *p = buf;
+    uint64_t width, height, head, food, score, nTail, nFree, ticks, seed, hash, rng[4];
+    if (size < SNAPSHOT_HEADER) {
+        return false;
+    }
+    p = GetLE(p, &width, 4);
+    p = GetLE(p, &height, 4);
+    p = GetLE(p, &head, 4);
+    p = GetLE(p, &food, 4);
+    p = GetLE(p, &score, 4);
+    p = GetLE(p, &nTail, 4);
+    p = GetLE(p, &nFree, 4);
+    uint8_t dir = *p++;
+    uint8_t lastMove = *p++;
+    uint8_t gameOver = *p++;
+    uint8_t gameWon = *p++;
+    p = GetLE(p, &ticks, 8);
+    p = GetLE(p, &seed, 8);
+    p = GetLE(p, &hash, 8);
+    for (int i = 0; i < 4; i++) {
+        p = GetLE(p, &rng[i], 8);
+    }
+    int cells = g->cells;
+    int cb = CellBytes(cells);
+    if (width != (uint64_t)g->width || height != (uint64_t)g->height || head >= (uint64_t)cells ||
+        (food >= (uint64_t)cells && food != UINT32_MAX) || nTail >= (uint64_t)cells ||
+        nFree > (uint64_t)cells || dir > DOWN || lastMove > DOWN || gameOver > 1 || gameWon > 1 ||
+        size != SNAPSHOT_HEADER + (nTail + nFree) * (uint64_t)cb) {
+        return false;
+    }
+
+    // Rebuild the index in the saved slot order, checking that the body and
+    // the free cells cover the board exactly once (bar a dead head on its body)
+    g->nTail = (int)nTail;
+    g->nFree = (int)nFree;
+    g->tailStart = 0;
+    memset(g->occupied, 0, (size_t)cells);
+    g->occupied[head] = 1;
+    int covered = 1;
+    for (int i = 0; i < g->nTail; i++) {
+        uint64_t cell;
+        p = GetLE(p, &cell, cb);
+        if (cell >= (uint64_t)cells) {
+            return false;
+        }
+        g->tail[i] = (int)cell;
+        covered += !g->occupied[cell];
+        g->occupied[cell] = 1;
+    }
+    for (int i = 0; i < cells; i++) {
+        g->freePos[i] = -1;
+    }
+    for (int i = 0; i < g->nFree; i++) {
+        uint64_t cell;
+        p = GetLE(p, &cell, cb);
+        if (cell >= (uint64_t)cells || g->occupied[cell] || g->freePos[cell] >= 0) {
+            return false;
+        }
+        g->freeCells[i] = (int)cell;
+        g->freePos[cell] = i;
+    }
+    if (covered + g->nFree != cells || (food != UINT32_MAX && g->occupied[food] && !gameOver)) {
+        return false;
+    }
+
+    g->headX = (int)(head % (uint64_t)g->width);
+    g->headY = (int)(head / (uint64_t)g->width);
+    g->foodX = food == UINT32_MAX ? -1 : (int)(food % (uint64_t)g->width);
+    g->foodY = food == UINT32_MAX ? -1 : (int)(food / (uint64_t)g->width);
+    g->score = (int)(int32_t)score;
+    g->dir = (enum eDirection)dir;
+    g->lastMove = (enum eDirection)lastMove;
+    g->gameOver = gameOver;
+    g->gameWon = gameWon;
+    g->ticks = (unsigned long)ticks;
+    g->seed = seed;
+    for (int i = 0; i < 4; i++) {
+        g->rng.s[i] = rng[i];
+    }
+    g->hash = SnakeComputeHash(g);
+    return g->hash == hash; // Catches any corruption the checks above let through
+}
+
+// --- Save files ---
+// Layout: "SNKS", version (u32), image size (u64) and the FNV-1a hash of
+// the image (u64), then the SnakeSnapshotWrite() image, little-endian.
+#define SAVE_MAGIC "SNKS"
+#define SAVE_HEADER (4 + 4 + 8 + 8)
+
+static uint64_t Fnv1a(const uint8_t *p, size_t n) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < n; i++) {
+        h = (h ^ p[i]) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+int SnakeSaveFile(const SnakeGame *g, const char *path) {
+    size_t imageSize = SnakeSnapshotSize(g);
+    size_t size = SAVE_HEADER + imageSize;
+    uint8_t *buf = malloc(size);
+    char temp[4096];
+    int len = snprintf(temp, sizeof(temp), "%s.%ld.tmp", path, (long)getpid());
+    if (buf == NULL || len < 0 || (size_t)len >= sizeof(temp)) {
+        free(buf);
+        return -1;
+    }
+    SnakeSnapshotWrite(g, buf + SAVE_HEADER);
+    memcpy(buf, SAVE_MAGIC, 4);
+    uint8_t *p = PutLE(buf + 4, SNAKE_SAVE_VERSION, 4);
+    p = PutLE(p, imageSize, 8);
+    PutLE(p, Fnv1a(buf + SAVE_HEADER, imageSize), 8);
+
+    // Written whole to a temp file and renamed over the old save, so a
+    // crash at any point leaves either the old save or the new one
+    int fd = open(temp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool ok = fd >= 0;
+    for (size_t done = 0; ok && done < size;) {
+        ssize_t n = write(fd, buf + done, size - done);
+        ok = n > 0;
+        done += ok ? (size_t)n : 0;
+    }
+    ok = ok && fsync(fd) == 0;
+    if (fd >= 0) {
+        ok = close(fd) == 0 && ok;
+        ok = ok && rename(temp, path) == 0;
+        if (!ok) {
+            unlink(temp);
+        }
+    }
+    free(buf);
+    return ok ? 0 : -1;
+}
+
+SnakeGame *SnakeLoadFile(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    uint8_t *buf = NULL;
+    size_t size = 0;
+    // Body and free cells list each cell of the largest board at most twice
+    uint64_t maxSize = SAVE_HEADER + SNAPSHOT_HEADER + 2 * (uint64_t)SNAKE_SAVE_MAX_CELLS * 4;
+    if (fstat(fd, &st) == 0 && st.st_size >= SAVE_HEADER + SNAPSHOT_HEADER &&
+        (uint64_t)st.st_size <= maxSize) {
+        size = (size_t)st.st_size;
+        buf = malloc(size);
+    }
+    bool ok = buf != NULL && read(fd, buf, size) == (ssize_t)size;
+    close(fd);
+
+    uint64_t version, imageSize, checksum, width, height, nTail, nFree;
+    const uint8_t *image = NULL;
+    if (ok) {
+        const uint8_t *p = GetLE(buf + 4, &version, 4);
+        p = GetLE(p, &imageSize, 8);
+        image = GetLE(p, &checksum, 8);
+        GetLE(GetLE(image, &width, 4), &height, 4); // The image starts with the board size
+        GetLE(GetLE(image + 20, &nTail, 4), &nFree, 4);
+        ok = memcmp(buf, SAVE_MAGIC, 4) == 0 && version == SNAKE_SAVE_VERSION &&
+             imageSize == size - SAVE_HEADER && Fnv1a(image, imageSize) == checksum &&
+             width >= 1 && height >= 1 && width * height <= SNAKE_SAVE_MAX_CELLS;
+    }
+    if (ok) {
+        // The body and the free cells cover the board (bar a dead head on its
+        // body), and the image must be exactly as long as they say, so a
+        // small file cannot get a large board allocated
+        uint64_t cells = width * height;
+        ok = nTail < cells && nFree <= cells && nTail + nFree + 1 >= cells &&
+             imageSize == SNAPSHOT_HEADER + (nTail + nFree) * (uint64_t)CellBytes((int)cells);
+    }
+    SnakeGame *g = ok ? SnakeCreate((int)width, (int)height) : NULL;
+    if (g != NULL && !SnakeSnapshotRead(g, image, (size_t)imageSize)) {
+        SnakeDestroy(g);
+        g = NULL;
+    }
+    free(buf);
+    return g;
+}
@@ -0,0 +1,75 @@
+#ifndef SNAKE_STATE_H
+#define SNAKE_STATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "engine.h"
+
+// --- Compact Game Checkpoints ---
+// A SnakeState holds a game in a few cache lines for tree search and
+// rollouts: the counters, the RNG and the body as 2-bit moves from the head
+// towards the tail. Snakes of up to SNAKE_STATE_INLINE_SEGMENTS body
+// segments are stored inline, and such states are trivially copyable.
+// Longer bodies live in a reference-counted block that SnakeStateCopy()
+// shares and SnakeSave() only rewrites in place when nothing else holds it
+// (copy-on-write).
+//
+// The free-cell index is not stored. SnakeRestore() rebuilds it in cell
+// order, so a restored game is deterministic from its checkpoint but may
+// place later food on different free cells than the game it was saved
+// from. SnakeClone() copies a game exactly.
+
+#define SNAKE_STATE_INLINE_SEGMENTS 256
+
+typedef struct SnakeBodyBlock SnakeBodyBlock;
+
+typedef struct {
+    int32_t width, height;
+    int32_t head;             // Head cell
+    int32_t food;             // Food cell, -1 when the board is full
+    int32_t score;
+    int32_t nTail;            // Body segments behind the head
+    uint64_t ticks;
+    uint64_t seed;
+    SnakeRng rng;
+    uint8_t dir;              // enum eDirection of the next move
+    uint8_t lastMove;         // enum eDirection of the last move
+    uint8_t gameOver;
+    uint8_t gameWon;
+    uint8_t body[SNAKE_STATE_INLINE_SEGMENTS / 4]; // Inline moves, 4 per byte
+    SnakeBodyBlock *shared;   // Moves for longer bodies, NULL otherwise
+} SnakeState;
+
+// --- Checkpoints ---
+// A zero-initialized SnakeState is a valid, empty target for SnakeSave().
+bool SnakeSave(const SnakeGame *game, SnakeState *state); // false if out of memory
+// Restored food placement differs from the saved game's, see above.
+bool SnakeRestore(SnakeGame *game, const SnakeState *state); // false if the board size differs
+void SnakeStateCopy(SnakeState *dst, const SnakeState *src); // dst must not hold a body block
+void SnakeStateRelease(SnakeState *state);                 // Drop any shared body block
+
+// --- Exact snapshots ---
+// A flat little-endian image of a game that also keeps the RNG and the
+// order of the free-cell index, so a game read back places the same food
+// as the one written and replays identically. Cells are stored in 2 bytes
+// on boards of up to 65536 cells, else 4. SnakeSnapshotRead() checks the
+// image (body, free cells and hash) as it loads it; if it returns false
+// for any reason but the board size, reset the game before using it.
+size_t SnakeSnapshotSize(const SnakeGame *game);
+void SnakeSnapshotWrite(const SnakeGame *game, void *buf); // SnakeSnapshotSize() bytes
+bool SnakeSnapshotRead(SnakeGame *game, const void *buf, size_t size); // false if malformed or another size
+
+// --- Save files ---
+// A snapshot behind a header with a format version and a checksum, for
+// resuming a game in a later process. Saving writes a temp file and renames
+// it over path, so a crash never leaves a torn save; loading is one read().
+// A save file is untrusted: its board size and lengths are checked against
+// each other and against SNAKE_SAVE_MAX_CELLS before any game is allocated.
+#define SNAKE_SAVE_VERSION 1
+#define SNAKE_SAVE_MAX_CELLS (1 << 20) // Largest board a save is loaded for
+
+int SnakeSaveFile(const SnakeGame *game, const char *path); // 0, or -1 on failure
+SnakeGame *SnakeLoadFile(const char *path); // A new game (SnakeDestroy() it), NULL if missing or bad
+
+#endif
@@ -0,0 +1,127 @@
+#include "tt.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CACHE_LINE 64
+#define BUCKET_ENTRIES 4
+
+typedef struct {
+    atomic_ullong check;      // hash ^ data
+    atomic_ullong data;       // SnakeTTData packed into 64 bits
+} Entry;
+
+typedef struct {
+    _Alignas(CACHE_LINE) Entry entries[BUCKET_ENTRIES];
+} Bucket;
+
+struct SnakeTT {
+    Bucket *buckets;
+    uint64_t mask;            // Buckets - 1
+    SnakeTTPolicy policy;
+    atomic_uint generation;
+};
+
+// --- Pack the data so one word holds all of it ---
+static uint64_t Pack(SnakeTTData d) {
+    return (uint64_t)(uint32_t)d.value | (uint64_t)d.depth << 32 |
+           (uint64_t)d.move << 48 | (uint64_t)d.generation << 56;
+}
+
+static SnakeTTData Unpack(uint64_t w) {
+    return (SnakeTTData){ (int32_t)(uint32_t)w, (uint16_t)(w >> 32), (uint8_t)(w >> 48), (uint8_t)(w >> 56) };
+}
+
+SnakeTT *SnakeTTCreate(size_t bytes, SnakeTTPolicy policy) {
+    size_t buckets = 1;
+    while (buckets * 2 * sizeof(Bucket) <= bytes) {
+        buckets *= 2;
+    }
+    SnakeTT *tt = malloc(sizeof(SnakeTT));
+    if (tt == NULL) {
+        return NULL;
+    }
+    tt->buckets = aligned_alloc(CACHE_LINE, buckets * sizeof(Bucket));
+    if (tt->buckets == NULL) {
+        free(tt);
+        return NULL;
+    }
+    tt->mask = buckets - 1;
+    tt->policy = policy;
+    atomic_init(&tt->generation, 0);
+    SnakeTTClear(tt);
+    return tt;
+}
+
+void SnakeTTDestroy(SnakeTT *tt) {
+    if (tt != NULL) {
+        free(tt->buckets);
+        free(tt);
+    }
+}
+
+// All-zero entries are empty: probes skip them and stores fill them first
+void SnakeTTClear(SnakeTT *tt) {
+    memset(tt->buckets, 0, (tt->mask + 1) * sizeof(Bucket));
+}
+
+void SnakeTTNewSearch(SnakeTT *tt) {
+    atomic_fetch_add_explicit(&tt->generation, 1, memory_order_relaxed);
+}
+
+bool SnakeTTProbe(const SnakeTT *tt, uint64_t hash, SnakeTTData *data) {
+    Bucket *b = &tt->buckets[hash & tt->mask];
+    for (int i = 0; i < BUCKET_ENTRIES; i++) {
+        uint64_t d = atomic_load_explicit(&b->entries[i].data, memory_order_relaxed);
+        uint64_t check = atomic_load_explicit(&b->entries[i].check, memory_order_relaxed);
+        if ((check ^ d) == hash && (d | check) != 0) { // All zero is an empty entry
+            *data = Unpack(d);
+            return true;
+        }
+    }
+    return false;
+}
+
+void SnakeTTStore(SnakeTT *tt, uint64_t hash, SnakeTTData data) {
+    Bucket *b = &tt->buckets[hash & tt->mask];
+    uint8_t generation = (uint8_t)atomic_load_explicit(&tt->generation, memory_order_relaxed);
+    data.generation = generation;
+
+    // The same position again is always overwritten in place
+    int victim = -1;
+    int victimScore = 0;
+    for (int i = 0; i < BUCKET_ENTRIES; i++) {
+        uint64_t d = atomic_load_explicit(&b->entries[i].data, memory_order_relaxed);
+        uint64_t check = atomic_load_explicit(&b->entries[i].check, memory_order_relaxed);
+        if ((check ^ d) == hash) {
+            victim = i;
+            break;
+        }
+        SnakeTTData old = Unpack(d);
+        int score;
+        switch (tt->policy) {
+            case SNAKE_TT_DEPTH:
+                score = old.depth;
+                break;
+            case SNAKE_TT_AGED:
+                // Entries from older searches first, then the shallowest
+                score = (old.generation == generation ? 1 << 16 : 0) + old.depth;
+                break;
+            default:
+                score = i; // Entry 0 first
+                break;
+        }
+        if (d == 0 && check == 0) {
+            score = -1; // Empty entries go before anything
+        }
+        if (victim < 0 || score < victimScore) {
+            victim = i;
+            victimScore = score;
+        }
+    }
+
+    uint64_t d = Pack(data);
+    atomic_store_explicit(&b->entries[victim].data, d, memory_order_relaxed);
+    atomic_store_explicit(&b->entries[victim].check, hash ^ d, memory_order_relaxed);
+}
@@ -0,0 +1,45 @@
+#ifndef SNAKE_TT_H
+#define SNAKE_TT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// --- Transposition Table ---
+// A fixed-size table of search results keyed by SnakeHash(), shared by any
+// number of threads without locks. Each entry is two 64-bit words, the
+// data and the key XOR the data. Writers store both words with plain
+// atomic stores; a reader accepts an entry only if its two words XOR back
+// to the key it asked for, so a torn read of half an old and half a new
+// entry fails the check and is treated as a miss.
+//
+// Entries sit in buckets of four, one cache line. A hash picks the bucket;
+// the replacement policy picks which of its entries a store overwrites
+// when the position is not already there.
+
+typedef enum {
+    SNAKE_TT_ALWAYS,          // Overwrite the bucket's first entry
+    SNAKE_TT_DEPTH,           // Overwrite the shallowest entry
+    SNAKE_TT_AGED             // Overwrite an entry from an older search first, then the shallowest
+} SnakeTTPolicy;
+
+typedef struct {
+    int32_t value;            // Caller-defined, e.g. a fixed-point score
+    uint16_t depth;           // Search depth or visit count the value is worth
+    uint8_t move;             // Best enum eDirection found, or STOP
+    uint8_t generation;       // Set by SnakeTTStore() from SnakeTTNewSearch()
+} SnakeTTData;
+
+typedef struct SnakeTT SnakeTT;
+
+// --- Lifetime: bytes is rounded down to a power-of-two number of buckets ---
+SnakeTT *SnakeTTCreate(size_t bytes, SnakeTTPolicy policy);
+void SnakeTTDestroy(SnakeTT *tt);
+void SnakeTTClear(SnakeTT *tt);          // Not safe while other threads use the table
+void SnakeTTNewSearch(SnakeTT *tt);      // Age every entry stored so far
+
+// --- Lookup and store, safe from any thread ---
+bool SnakeTTProbe(const SnakeTT *tt, uint64_t hash, SnakeTTData *data);
+void SnakeTTStore(SnakeTT *tt, uint64_t hash, SnakeTTData data);
+
+#endif
@@ -0,0 +1,186 @@
+#include "verify.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define CHUNK 16                  // Replays a thread takes at a time
+
+static const char *verdictNames[SNAKE_VERDICTS] = {
+    "valid", "incomplete", "diverged", "bad-keyframe", "ended-early", "mismatch", "malformed",
+    "too-large", "stalled",
+};
+
+const char *SnakeVerdictName(SnakeVerdictKind verdict) {
+    return (unsigned)verdict < SNAKE_VERDICTS ? verdictNames[verdict] : "unknown";
+}
+
+static void Fail(SnakeVerdict *v, SnakeVerdictKind verdict, unsigned long tick,
+                 uint64_t expected, uint64_t actual) {
+    v->verdict = verdict;
+    v->divergedAt = tick;
+    v->expectedHash = expected;
+    v->actualHash = actual;
+}
+
+void SnakeVerifyReplay(const SnakeReplay *r, SnakeGame *g, SnakeGame *scratch, SnakeVerdict *v) {
+    SnakeReplayCursor cursor;
+    SnakeReplayStart(&cursor, r, g);
+    *v = (SnakeVerdict){ SNAKE_VERDICT_VALID, 0, 0, r->complete ? r->score : 0, 0, 0, 0, 0 };
+
+    // Play to each checkpoint in turn: every keyframe, then the final tick
+    for (int k = 0; k <= r->nKeyframes; k++) {
+        unsigned long target = k < r->nKeyframes ? r->keyframes[k].tick : r->ticks;
+        while (g->ticks < target && SnakeReplayStep(&cursor, g, NULL)) {
+        }
+        v->ticks = g->ticks;
+        v->score = g->score;
+        if (g->ticks < target) {
+            Fail(v, cursor.stalled ? SNAKE_VERDICT_STALLED : SNAKE_VERDICT_ENDED_EARLY, g->ticks, 0, g->hash);
+            return;
+        }
+        if (k == r->nKeyframes) {
+            break;
+        }
+        if (!SnakeReplayKeyframeRead(r, k, scratch)) {
+            Fail(v, SNAKE_VERDICT_BAD_KEYFRAME, target, 0, g->hash);
+            SnakeReset(scratch, 0); // A failed read can leave it half loaded
+            return;
+        }
+        if (scratch->hash != g->hash || scratch->score != g->score) {
+            Fail(v, SNAKE_VERDICT_DIVERGED, target, scratch->hash, g->hash);
+            return;
+        }
+        v->lastGood = target;
+    }
+
+    if (!r->complete) {
+        v->verdict = SNAKE_VERDICT_INCOMPLETE;
+    } else if (g->score != r->score || g->hash != r->hash) {
+        Fail(v, SNAKE_VERDICT_MISMATCH, g->ticks, r->hash, g->hash);
+    }
+}
+
+// --- Batch: threads take chunks of replays off a shared counter ---
+typedef struct {
+    const SnakeReplay *const *replays; // Or, when NULL, corpus
+    const SnakeCorpus *corpus;
+    uint64_t count;
+    SnakeVerdict *verdicts;
+    atomic_uint_fast64_t next;
+    atomic_bool failed;
+} Batch;
+
+typedef struct {
+    uint8_t *mem;             // Room for two games
+    size_t capacity;
+    int width, height;        // Of the games built in mem, 0 for none
+    SnakeGame *game, *scratch;
+} Games;
+
+// --- Size the thread's two games for a board; false if out of memory ---
+static bool Prepare(Games *games, int width, int height, SnakeGame **g, SnakeGame **scratch) {
+    if (width != games->width || height != games->height) {
+        size_t size = (SnakeGameSize(width, height) + 63) & ~(size_t)63;
+        if (2 * size > games->capacity) {
+            free(games->mem);
+            games->mem = malloc(2 * size);
+            games->capacity = games->mem != NULL ? 2 * size : 0;
+            games->width = 0;
+            if (games->mem == NULL) {
+                return false;
+            }
+        }
+        games->game = SnakeInit(games->mem, width, height);
+        games->scratch = SnakeInit(games->mem + size, width, height);
+        games->width = width;
+        games->height = height;
+    }
+    *g = games->game;
+    *scratch = games->scratch;
+    return true;
+}
+
+// --- Verify one parsed replay; false only if memory runs out ---
+static bool Check(const SnakeReplay *r, Games *games, SnakeVerdict *v) {
+    if ((uint64_t)r->width * (uint64_t)r->height > SNAKE_REPLAY_MAX_CELLS) {
+        *v = (SnakeVerdict){ SNAKE_VERDICT_TOO_LARGE, 0, 0, r->complete ? r->score : 0, 0, 0, 0, 0 };
+        return true;
+    }
+    SnakeGame *g, *scratch;
+    if (!Prepare(games, r->width, r->height, &g, &scratch)) {
+        return false;
+    }
+    SnakeVerifyReplay(r, g, scratch, v);
+    return true;
+}
+
+static bool VerifyOne(Batch *b, uint64_t i, Games *games) {
+    SnakeVerdict *v = &b->verdicts[i];
+    if (b->replays != NULL) {
+        return Check(b->replays[i], games, v);
+    }
+
+    size_t size;
+    const uint8_t *data = SnakeCorpusGame(b->corpus, i, &size);
+    SnakeReplayFile *f = SnakeReplayOpenMemory(data, size);
+    if (f == NULL || f->count != 1) {
+        *v = (SnakeVerdict){ SNAKE_VERDICT_MALFORMED, 0, 0, 0, 0, 0, 0, 0 };
+        SnakeReplayClose(f);
+        return true;
+    }
+    bool ok = Check(&f->games[0], games, v);
+    SnakeReplayClose(f);
+    return ok;
+}
+
+static void *Worker(void *arg) {
+    Batch *b = arg;
+    Games games = { NULL, 0, 0, 0, NULL, NULL };
+    while (!atomic_load_explicit(&b->failed, memory_order_relaxed)) {
+        uint64_t start = atomic_fetch_add_explicit(&b->next, CHUNK, memory_order_relaxed);
+        if (start >= b->count) {
+            break;
+        }
+        uint64_t end = start + CHUNK < b->count ? start + CHUNK : b->count;
+        for (uint64_t i = start; i < end; i++) {
+            if (!VerifyOne(b, i, &games)) {
+                atomic_store(&b->failed, true);
+                break;
+            }
+        }
+    }
+    free(games.mem);
+    return NULL;
+}
+
+static int Run(Batch *b, int threads) {
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    pthread_t ids[threads > 1 ? threads - 1 : 1];
+    int started = 0;
+    for (; started < threads - 1; started++) {
+        if (pthread_create(&ids[started], NULL, Worker, b) != 0) {
+            break; // Carry on with fewer threads
+        }
+    }
+    Worker(b);
+    for (int k = 0; k < started; k++) {
+        pthread_join(ids[k], NULL);
+    }
+    return atomic_load(&b->failed) ? -1 : 0;
+}
+
+int SnakeVerifyAll(const SnakeReplay *const *replays, uint64_t count, int threads,
+                   SnakeVerdict *verdicts) {
+    Batch b = { replays, NULL, count, verdicts, 0, false };
+    return Run(&b, threads);
+}
+
+int SnakeVerifyCorpus(const SnakeCorpus *corpus, int threads, SnakeVerdict *verdicts) {
+    Batch b = { NULL, corpus, corpus->count, verdicts, 0, false };
+    return Run(&b, threads);
+}
@@ -0,0 +1,63 @@
+#ifndef SNAKE_VERIFY_H
+#define SNAKE_VERIFY_H
+
+#include <stdint.h>
+
+#include "corpus.h"
+#include "replay.h"
+
+// --- Replay Verification ---
+// Re-simulates a replay from its seed and moves and checks it against what
+// it claims: every keyframe is a checkpoint of the game's hash, score and
+// tick, and the end record claims the final score and hash. Checking stops
+// at the first disagreement, which the verdict locates between the last
+// checkpoint that matched and the first that did not. That is as exact as
+// it gets: nothing is recorded between checkpoints to compare against, so
+// the divergence lies somewhere in up to a keyframe interval of ticks.
+//
+// Replays are untrusted input: one that claims a board over
+// SNAKE_REPLAY_MAX_CELLS cells gets its own verdict instead of the memory
+// to simulate it, one whose snake goes longer without eating than any real
+// game (see SnakeReplayStep()) gets one instead of the time to play it out,
+// and the rest of the batch carries on.
+
+typedef enum {
+    SNAKE_VERDICT_VALID,      // Every checkpoint and the final result match
+    SNAKE_VERDICT_INCOMPLETE, // No end record, so nothing is claimed
+    SNAKE_VERDICT_DIVERGED,   // A keyframe disagrees with the simulated game
+    SNAKE_VERDICT_BAD_KEYFRAME, // A keyframe image does not load
+    SNAKE_VERDICT_ENDED_EARLY, // The simulated game ended before the claimed final tick
+    SNAKE_VERDICT_MISMATCH,   // Final score or hash differ from the claim
+    SNAKE_VERDICT_MALFORMED,  // Replay bytes do not parse
+    SNAKE_VERDICT_TOO_LARGE,  // Board over SNAKE_REPLAY_MAX_CELLS cells, not simulated
+    SNAKE_VERDICT_STALLED,    // Went too long without eating to be a real game
+    SNAKE_VERDICTS
+} SnakeVerdictKind;
+
+typedef struct {
+    SnakeVerdictKind verdict;
+    unsigned long ticks;      // Ticks simulated
+    int score;                // Simulated score when checking stopped
+    int claimedScore;         // From the end record, if any
+    unsigned long lastGood;   // Tick of the last checkpoint that matched (0 is the reset)
+    unsigned long divergedAt; // Tick of the first one that did not, for a failed verdict
+    uint64_t expectedHash, actualHash; // At divergedAt
+} SnakeVerdict;
+
+const char *SnakeVerdictName(SnakeVerdictKind verdict);
+
+// --- Verify one replay ---
+// game and scratch are two games of the replay's size, overwritten.
+void SnakeVerifyReplay(const SnakeReplay *replay, SnakeGame *game, SnakeGame *scratch,
+                       SnakeVerdict *verdict);
+
+// --- Verify many on every core ---
+// threads <= 0 uses every core. Return 0, or -1 if memory runs out for a
+// board within the cap.
+int SnakeVerifyAll(const SnakeReplay *const *replays, uint64_t count, int threads,
+                   SnakeVerdict *verdicts);
+
+// Every game of a corpus, parsed from the mapping by the worker that checks it.
+int SnakeVerifyCorpus(const SnakeCorpus *corpus, int threads, SnakeVerdict *verdicts);
+
+#endif